@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#include "Config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "Str.h"
+#include "Thread.h"
+#include "FileCache.h"
+
+
+/**
+ * Implementation of the FileCache Facade for Unix systems.
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/* ----------------------------------------------------------- Definitions */
+
+
+#define BUCKETS 64
+#define MAX_FILES 256
+
+
+typedef struct Entry_T {
+        int fd;
+        char *path;
+        struct Entry_T *next;
+} *Entry_T;
+
+
+static struct {
+        int files;
+        unsigned long long reads;
+        unsigned long long opens;
+        Entry_T table[BUCKETS];
+} _cache = {};
+
+static Mutex_T _mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* --------------------------------------------------------------- Private */
+
+
+static unsigned _hash(const char *path) {
+        unsigned h = 5381;
+        while (*path)
+                h = ((h << 5) + h) + (unsigned char)*path++;
+        return h % BUCKETS;
+}
+
+
+static int _open(const char *path) {
+        _cache.opens++;
+        return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+
+// Returns the cached descriptor for path, open a new one if not cached. If the cache is full, *transient is set to true and the caller has to close the descriptor
+static int _get(const char *path, boolean_t *transient) {
+        unsigned h = _hash(path);
+        for (Entry_T e = _cache.table[h]; e; e = e->next)
+                if (Str_isEqual(e->path, path))
+                        return e->fd;
+        int fd = _open(path);
+        if (fd >= 0) {
+                if (_cache.files < MAX_FILES) {
+                        Entry_T e;
+                        NEW(e);
+                        e->fd = fd;
+                        e->path = Str_dup(path);
+                        e->next = _cache.table[h];
+                        _cache.table[h] = e;
+                        _cache.files++;
+                } else {
+                        *transient = true;
+                }
+        }
+        return fd;
+}
+
+
+static void _remove(const char *path) {
+        for (Entry_T *p = &_cache.table[_hash(path)]; *p; p = &(*p)->next) {
+                if (Str_isEqual((*p)->path, path)) {
+                        Entry_T e = *p;
+                        *p = e->next;
+                        close(e->fd);
+                        FREE(e->path);
+                        FREE(e);
+                        _cache.files--;
+                        return;
+                }
+        }
+}
+
+
+static ssize_t _read(const char *path, char *buf, size_t size) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+                boolean_t transient = false;
+                int fd = _get(path, &transient);
+                if (fd < 0)
+                        return -1;
+                _cache.reads++;
+                ssize_t n = pread(fd, buf, size - 1, 0);
+                if (transient) {
+                        int _errno = errno;
+                        close(fd);
+                        errno = _errno;
+                }
+                if (n >= 0) {
+                        buf[n] = 0;
+                        return n;
+                }
+                if (transient || (errno != ENODEV && errno != ESTALE && errno != ENOENT && errno != EBADF))
+                        break;
+                // The file vanished or was replaced since it was opened (e.g. interface or block device removed) => reopen
+                int _errno = errno;
+                _remove(path);
+                errno = _errno;
+        }
+        return -1;
+}
+
+
+/* ---------------------------------------------------------------- Public */
+
+
+ssize_t FileCache_read(const char *path, char *buf, size_t size) {
+        assert(path);
+        assert(buf);
+        assert(size > 0);
+        ssize_t n;
+        LOCK(_mutex)
+        {
+                n = _read(path, buf, size);
+        }
+        END_LOCK;
+        return n;
+}
+
+
+ssize_t FileCache_readAll(const char *path, char **buf, size_t *size) {
+        assert(path);
+        assert(buf);
+        assert(size);
+        if (! *buf || *size < 2) {
+                *size = *size < 4096 ? 4096 : *size;
+                RESIZE(*buf, *size);
+        }
+        ssize_t n;
+        LOCK(_mutex)
+        {
+                // The pseudo-file size is unknown (stat reports 0 or 4096) => grow the buffer until the content fits
+                while ((n = _read(path, *buf, *size)) == (ssize_t)*size - 1) {
+                        *size *= 2;
+                        RESIZE(*buf, *size);
+                }
+        }
+        END_LOCK;
+        return n;
+}
+
+
+void FileCache_clear(void) {
+        LOCK(_mutex)
+        {
+                for (int i = 0; i < BUCKETS; i++) {
+                        while (_cache.table[i]) {
+                                Entry_T e = _cache.table[i];
+                                _cache.table[i] = e->next;
+                                close(e->fd);
+                                FREE(e->path);
+                                FREE(e);
+                        }
+                }
+                _cache.files = 0;
+        }
+        END_LOCK;
+}
+
+
+void FileCache_statistics(int *files, unsigned long long *reads, unsigned long long *opens) {
+        LOCK(_mutex)
+        {
+                if (files)
+                        *files = _cache.files;
+                if (reads)
+                        *reads = _cache.reads;
+                if (opens)
+                        *opens = _cache.opens;
+        }
+        END_LOCK;
+}
+
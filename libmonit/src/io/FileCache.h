@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#ifndef FILECACHE_INCLUDED
+#define FILECACHE_INCLUDED
+#include <sys/types.h>
+
+
+/**
+ * A cache of open file descriptors for pseudo-files such as entries in
+ * the /proc and /sys filesystems. Such files are read repeatedly, each
+ * monitoring cycle, and their content is generated by the kernel on read.
+ * Instead of open/read/close each time, the descriptor is kept open and
+ * the file is re-read from offset 0 with pread(2). If the underlying
+ * object vanished (for example a network interface was removed and
+ * the descriptor returns ENODEV or ESTALE) the file is reopened once.
+ *
+ * The cache holds at most a fixed number of descriptors, files beyond
+ * that limit are read with a plain open/read/close. Files which are
+ * specific to a process (/proc/&lt;PID&gt;/...) should not be read via this
+ * cache as the set of processes changes constantly.
+ *
+ * This class is thread-safe.
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/**
+ * Read up to <code>size - 1</code> bytes from the beginning of the file
+ * <code>path</code> into <code>buf</code>. The buffer is NUL terminated.
+ * @param path An absolute file path
+ * @param buf The buffer to read into
+ * @param size The size of the buffer
+ * @return The number of bytes read or -1 if the file cannot be read, in
+ * which case errno is set accordingly
+ */
+ssize_t FileCache_read(const char *path, char *buf, size_t size);
+
+
+/**
+ * Read the whole file <code>path</code> into the buffer <code>*buf</code>
+ * of size <code>*size</code>. The buffer is allocated if <code>*buf</code>
+ * is NULL and grown as needed; the caller owns the buffer and should
+ * reuse it for subsequent reads of the same file. The buffer is NUL
+ * terminated.
+ * @param path An absolute file path
+ * @param buf A pointer to the buffer to read into
+ * @param size A pointer to the size of the buffer
+ * @return The number of bytes read or -1 if the file cannot be read, in
+ * which case errno is set accordingly
+ */
+ssize_t FileCache_readAll(const char *path, char **buf, size_t *size);
+
+
+/**
+ * Close all cached file descriptors
+ */
+void FileCache_clear(void);
+
+
+/**
+ * Returns the cache statistics. Each read served by a cached descriptor
+ * saves one open(2) and one close(2) system call.
+ * @param files Output: the number of currently cached files
+ * @param reads Output: the total number of reads
+ * @param opens Output: the total number of open(2) calls
+ */
+void FileCache_statistics(int *files, unsigned long long *reads, unsigned long long *opens);
+
+
+#endif
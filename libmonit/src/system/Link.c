@@ -64,6 +64,7 @@
 #include "system/Time.h"
 #include "system/System.h"
 #include "Str.h"
+#include "FileCache.h"
 
 
 /**
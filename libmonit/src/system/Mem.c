@@ -43,6 +43,13 @@
  */
 
 
+/* ----------------------------------------------------------- Definitions */
+
+
+static unsigned long long allocated = 0ULL;
+static unsigned long long freed = 0ULL;
+
+
 /* ---------------------------------------------------------------- Public */
 
 
@@ -52,6 +59,7 @@ void *Mem_alloc(long nbytes, const char *func, const char *file, int line){
 	ptr = malloc(nbytes);
 	if (ptr == NULL)
                 Exception_throw(&(MemoryException), func, file, line, System_getLastError());
+	__atomic_fetch_add(&allocated, 1, __ATOMIC_RELAXED);
 	return ptr;
 }
 
@@ -63,13 +71,16 @@ void *Mem_calloc(long count, long nbytes, const char *func, const char *file, in
 	ptr = calloc(count, nbytes);
 	if (ptr == NULL)
                 Exception_throw(&(MemoryException), func, file, line, System_getLastError());
+	__atomic_fetch_add(&allocated, 1, __ATOMIC_RELAXED);
 	return ptr;
 }
 
 
 void Mem_free(void *ptr, const char *func, const char *file, int line) {
-	if (ptr)
+	if (ptr) {
 		free(ptr);
+		__atomic_fetch_add(&freed, 1, __ATOMIC_RELAXED);
+	}
 }
 
 
@@ -80,5 +91,14 @@ void *Mem_resize(void *ptr, long nbytes, const char *func, const char *file, int
 	ptr = realloc(ptr, nbytes);
 	if (ptr == NULL)
                 Exception_throw(&(MemoryException), func, file, line, System_getLastError());
+	__atomic_fetch_add(&allocated, 1, __ATOMIC_RELAXED);
 	return ptr;
 }
+
+
+void Mem_statistics(unsigned long long *allocations, unsigned long long *frees) {
+	assert(allocations);
+	assert(frees);
+	*allocations = __atomic_load_n(&allocated, __ATOMIC_RELAXED);
+	*frees = __atomic_load_n(&freed, __ATOMIC_RELAXED);
+}
@@ -153,4 +153,13 @@ void Mem_free(void *p, const char *func, const char *file, int line);
 void *Mem_resize(void *p, long size, const char *func, const char *file, int line);
 
 
+/**
+ * Get the memory allocation statistics since the program start. The
+ * counters are updated atomically and are safe to read from any thread.
+ * @param allocations Output: number of allocations and reallocations
+ * @param frees Output: number of deallocations
+ */
+void Mem_statistics(unsigned long long *allocations, unsigned long long *frees);
+
+
 #endif
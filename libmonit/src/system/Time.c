@@ -26,6 +26,7 @@
 #include "Config.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
@@ -501,6 +502,30 @@ long long int Time_micro(void) {
 }
 
 
+long long int Time_monotonic(void) {
+#ifdef CLOCK_MONOTONIC
+        struct timespec t;
+        if (clock_gettime(CLOCK_MONOTONIC, &t) != 0)
+                THROW(AssertException, "%s", System_getLastError());
+        return (long long int)t.tv_sec * 1000  +  (long long int)t.tv_nsec / 1000000;
+#else
+        return Time_milli();
+#endif
+}
+
+
+long long int Time_monotonicMicro(void) {
+#ifdef CLOCK_MONOTONIC
+        struct timespec t;
+        if (clock_gettime(CLOCK_MONOTONIC, &t) != 0)
+                THROW(AssertException, "%s", System_getLastError());
+        return (long long int)t.tv_sec * 1000000  +  (long long int)t.tv_nsec / 1000;
+#else
+        return Time_micro();
+#endif
+}
+
+
 int Time_seconds(time_t time) {
         struct tm tm;
         localtime_r(&time, &tm);
@@ -796,6 +821,112 @@ parse:
 }
 
 
+int Time_cronCompile(const char *cron, TimeCron_T *spec) {
+        assert(cron);
+        assert(spec);
+        static const struct {int min; int max;} limits[] = {{0, 59}, {0, 23}, {1, 31}, {1, 12}, {0, 7}};
+        unsigned long long fields[5] = {};
+        int n = 0;
+        const char *p = cron;
+        while (true) {
+                while (isspace(*p))
+                        p++;
+                if (! *p)
+                        break;
+                if (n == 5)
+                        return false; // Too many fields
+                // Field is a comma separated sequence of "*", numbers and ranges
+                while (true) {
+                        int from, to;
+                        if (*p == '*') {
+                                from = limits[n].min;
+                                to = limits[n].max;
+                                p++;
+                        } else if (isdigit(*p)) {
+                                char *e;
+                                from = to = (int)strtol(p, &e, 10);
+                                p = e;
+                                if (*p == '-') {
+                                        if (! isdigit(*++p))
+                                                return false;
+                                        to = (int)strtol(p, &e, 10);
+                                        p = e;
+                                }
+                                if (from < limits[n].min || to > limits[n].max || from > to)
+                                        return false;
+                        } else {
+                                return false;
+                        }
+                        for (int i = from; i <= to; i++)
+                                fields[n] |= 1ULL << i;
+                        const char *q = p;
+                        while (isspace(*q))
+                                q++;
+                        if (*q != ',')
+                                break;
+                        for (p = q + 1; isspace(*p); p++)
+                                ;
+                }
+                if (*p && ! isspace(*p))
+                        return false;
+                n++;
+        }
+        if (n != 5)
+                return false; // Too few fields
+        spec->minutes = fields[0];
+        spec->hours = (unsigned int)fields[1];
+        spec->days = (unsigned int)fields[2];
+        spec->months = (unsigned int)fields[3];
+        spec->weekdays = (unsigned int)(fields[4] & 0x7f) | (fields[4] >> 7 & 1); // Both 0 and 7 are Sunday
+        return true;
+}
+
+
+static inline int _cronDay(TimeCron_T *spec, struct tm *tm) {
+        return (spec->months >> (tm->tm_mon + 1) & 1) && (spec->days >> tm->tm_mday & 1) && (spec->weekdays >> tm->tm_wday & 1);
+}
+
+
+int Time_cronMatch(TimeCron_T *spec, time_t time) {
+        assert(spec);
+        struct tm tm;
+        localtime_r(&time, &tm);
+        return _cronDay(spec, &tm) && (spec->hours >> tm.tm_hour & 1) && (spec->minutes >> tm.tm_min & 1);
+}
+
+
+time_t Time_cronNext(TimeCron_T *spec, time_t time) {
+        assert(spec);
+        struct tm tm;
+        localtime_r(&time, &tm);
+        tm.tm_sec = 0;
+        tm.tm_min++;
+        // Skip whole months, days and hours which don't match. The number of steps is bounded so an impossible date such as February 30 terminates
+        for (int i = 0; i < 10000; i++) {
+                tm.tm_isdst = -1;
+                time_t t = mktime(&tm); // Normalize the fields after a step
+                if (t == (time_t)-1)
+                        break;
+                if (! (spec->months >> (tm.tm_mon + 1) & 1)) {
+                        tm.tm_mon++;
+                        tm.tm_mday = 1;
+                        tm.tm_hour = tm.tm_min = 0;
+                } else if (! _cronDay(spec, &tm)) {
+                        tm.tm_mday++;
+                        tm.tm_hour = tm.tm_min = 0;
+                } else if (! (spec->hours >> tm.tm_hour & 1)) {
+                        tm.tm_hour++;
+                        tm.tm_min = 0;
+                } else if (! (spec->minutes >> tm.tm_min & 1)) {
+                        tm.tm_min++;
+                } else {
+                        return t;
+                }
+        }
+        return 0;
+}
+
+
 void Time_usleep(long u) {
 #ifdef NETBSD
         // usleep is broken on NetBSD (at least in version 5.1)
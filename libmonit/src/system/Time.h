@@ -132,6 +132,29 @@ long long int Time_milli(void);
 long long int Time_micro(void);
 
 
+/**
+ * Returns the time of a monotonic clock measured in milliseconds. The
+ * clock has no relation to the wall-clock time and is not affected by
+ * system time changes, it is intended for measuring intervals and for
+ * scheduling. Where a monotonic clock is not available, the value of
+ * Time_milli() is returned.
+ * @return A 64 bits long representing milliseconds since an unspecified
+ * point in the past
+ * @exception AssertException If time could not be obtained
+ */
+long long int Time_monotonic(void);
+
+
+/**
+ * Returns the time of a monotonic clock measured in microseconds. See
+ * Time_monotonic() for details.
+ * @return A 64 bits long representing microseconds since an unspecified
+ * point in the past
+ * @exception AssertException If time could not be obtained
+ */
+long long int Time_monotonicMicro(void);
+
+
 /**
  * Returns the second of the minute for time.
  * @param time Number of seconds since the EPOCH
@@ -312,6 +335,55 @@ char *Time_uptime(time_t sec, char result[24]);
 int Time_incron(const char *cron, time_t time);
 
 
+/**
+ * A cron format string compiled by Time_cronCompile(). Each field is a
+ * bitset where bit <i>n</i> is set if the value <i>n</i> matches.
+ */
+typedef struct TimeCron_T {
+        unsigned long long minutes;                        /**< Minutes 0-59 */
+        unsigned int hours;                                  /**< Hours 0-23 */
+        unsigned int days;                            /**< Day of month 1-31 */
+        unsigned int months;                                /**< Month 1-12 */
+        unsigned int weekdays;                        /**< Day of week 0-6, 0 = Sunday */
+} TimeCron_T;
+
+
+/**
+ * Compile a cron format string into bitsets so it can be tested with
+ * Time_cronMatch() and Time_cronNext() without parsing the string again.
+ * The format is the same as for Time_incron(), but values out of the
+ * field range and empty ranges (e.g. 9-8) are rejected. As in crontab(5),
+ * both 0 and 7 are accepted for Sunday in the weekday field.
+ * @param cron A crontab format string. e.g. "* 8-9 * * *"
+ * @param spec The compiled cron specification
+ * @return 1 if the cron string is valid, otherwise 0
+ */
+int Time_cronCompile(const char *cron, TimeCron_T *spec);
+
+
+/**
+ * Returns 1 if the given time is in the range of the compiled cron
+ * specification, otherwise 0. Same as Time_incron() but requires
+ * only one local time conversion.
+ * @param spec A cron specification compiled with Time_cronCompile()
+ * @param time The time to test if in range of the cron specification
+ * @return 1 if time is in cron range, otherwise 0
+ */
+int Time_cronMatch(TimeCron_T *spec, time_t time);
+
+
+/**
+ * Returns the start of the next minute after <code>time</code> which
+ * matches the compiled cron specification. Example, for "0 12 * * *" and
+ * a time 2011-07-05 11:27:05 the result is 2011-07-05 12:00:00
+ * @param spec A cron specification compiled with Time_cronCompile()
+ * @param time The time to search from
+ * @return The next matching time or 0 if the specification doesn't match
+ * any time in the next years (e.g. "0 0 30 2 *")
+ */
+time_t Time_cronNext(TimeCron_T *spec, time_t time);
+
+
 /**
  * This method suspend the calling process or Thread for
  * <code>u</code> micro seconds.
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#include "Config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "Arena.h"
+
+
+/**
+ * Implementation of the Arena interface. Memory is taken from a list
+ * of chunks; a new chunk is linked in front when the current chunk is
+ * full and all chunks are released by Arena_free().
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/* ----------------------------------------------------------- Definitions */
+
+
+#define T Arena_T
+
+typedef union align_t {
+        long long l;
+        long double d;
+        void *p;
+        void (*f)(void);
+} align_t;
+
+#define ALIGN(n) (((n) + sizeof(align_t) - 1) / sizeof(align_t) * sizeof(align_t))
+
+typedef struct chunk_t {
+        struct chunk_t *next;
+        long size;
+        long avail;
+        union {
+                align_t align;
+                unsigned char data[1];
+        } u;
+} *chunk_t;
+
+struct T {
+        int hint;
+        long used;
+        long size;
+        chunk_t chunks;
+};
+
+
+/* --------------------------------------------------------------- Private */
+
+
+static chunk_t _chunk(T A, long size, const char *func, const char *file, int line) {
+        chunk_t c = Mem_alloc((long)offsetof(struct chunk_t, u) + size, func, file, line);
+        c->size = size;
+        c->avail = size;
+        A->size += (long)offsetof(struct chunk_t, u) + size;
+        return c;
+}
+
+
+/* ---------------------------------------------------------------- Public */
+
+
+T Arena_new(int hint) {
+        T A;
+        if (hint <= 0)
+                THROW(AssertException, "Illegal hint value");
+        NEW(A);
+        A->hint = hint;
+        A->size = sizeof(*A);
+        return A;
+}
+
+
+void Arena_free(T *A) {
+        assert(A && *A);
+        for (chunk_t c = (*A)->chunks, next; c; c = next) {
+                next = c->next;
+                FREE(c);
+        }
+        FREE(*A);
+}
+
+
+void *Arena_alloc(T A, long size, const char *func, const char *file, int line) {
+        assert(A);
+        assert(size > 0);
+        long n = ALIGN(size);
+        chunk_t c = A->chunks;
+        if (! c || c->avail < n) {
+                if (n > A->hint) {
+                        // Large object gets its own chunk behind the current chunk, so the free space in the current chunk is not lost
+                        chunk_t large = _chunk(A, n, func, file, line);
+                        if (c) {
+                                large->next = c->next;
+                                c->next = large;
+                        } else {
+                                large->next = NULL;
+                                A->chunks = large;
+                        }
+                        c = large;
+                } else {
+                        c = _chunk(A, A->hint, func, file, line);
+                        c->next = A->chunks;
+                        A->chunks = c;
+                }
+        }
+        void *p = c->u.data + (c->size - c->avail);
+        c->avail -= n;
+        A->used += size;
+        return p;
+}
+
+
+void *Arena_calloc(T A, long count, long size, const char *func, const char *file, int line) {
+        assert(count > 0);
+        assert(size > 0);
+        void *p = Arena_alloc(A, count * size, func, file, line);
+        memset(p, 0, count * size);
+        return p;
+}
+
+
+long Arena_used(T A) {
+        assert(A);
+        return A->used;
+}
+
+
+long Arena_size(T A) {
+        assert(A);
+        return A->size;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+
+/**
+ * An <b>Arena</b> is a region of memory from which objects with the
+ * same lifetime are allocated. Allocation is a pointer increment in a
+ * chunk and objects allocated one after another are laid out next to
+ * each other. Objects are not freed individually; all memory allocated
+ * from an Arena is released in one operation with Arena_free().
+ *
+ * This class is reentrant but not thread-safe
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+#define T Arena_T
+typedef struct T *T;
+
+
+/**
+ * Allocate object <code>p</code> from the Arena <code>A</code> and
+ * clear the memory region before the object is returned.
+ * @param A An Arena object
+ * @param p Object to allocate
+ * @exception MemoryException if allocation failed
+ * @hideinitializer
+ */
+#define ARENA_NEW(A, p) ((p) = Arena_calloc((A), 1, (long)sizeof *(p), __func__, __FILE__, __LINE__))
+
+
+/**
+ * Create a new Arena object.
+ * @param hint The size of the memory chunks in bytes (hint > 0). Objects
+ * larger than the hint get a chunk of their own
+ * @return A new Arena object
+ * @exception AssertException if hint is less than or equal to 0
+ * @exception MemoryException if allocation failed
+ */
+T Arena_new(int hint);
+
+
+/**
+ * Destroy the Arena and release all objects allocated from it
+ * @param A An Arena object reference
+ */
+void Arena_free(T *A);
+
+
+/**
+ * Allocate <code>size</code> bytes from the Arena. The memory is
+ * aligned for any object type. If allocation failed this throws a
+ * MemoryException
+ * @param A An Arena object
+ * @param size The number of bytes to allocate
+ * @param func the callee
+ * @param file location of caller
+ * @param line location of caller
+ * @return a pointer to the allocated memory
+ * @exception MemoryException if allocation failed
+ * @exception AssertException if <code>size <= 0</code>
+ */
+void *Arena_alloc(T A, long size, const char *func, const char *file, int line);
+
+
+/**
+ * Allocate memory for <code>count</code> objects, each of
+ * <code>size</code> bytes, from the Arena. The returned memory is
+ * cleared.
+ * @param A An Arena object
+ * @param count The number of objects to allocate
+ * @param size The size of each object to allocate
+ * @param func the callee
+ * @param file location of caller
+ * @param line location of caller
+ * @return a pointer to the allocated memory
+ * @exception MemoryException if allocation failed
+ * @exception AssertException if <code>count or size <= 0</code>
+ */
+void *Arena_calloc(T A, long count, long size, const char *func, const char *file, int line);
+
+
+/**
+ * Returns the number of bytes allocated from the Arena, excluding
+ * alignment padding and unused chunk space
+ * @param A An Arena object
+ * @return The number of bytes in use
+ */
+long Arena_used(T A);
+
+
+/**
+ * Returns the number of bytes the Arena has reserved from the system,
+ * including its own bookkeeping
+ * @param A An Arena object
+ * @return The size of the Arena in bytes
+ */
+long Arena_size(T A);
+
+
+#undef T
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+
+#include "Config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "Thread.h"
+#include "Atom.h"
+
+
+/**
+ * Implementation of the Atom interface. Atoms are kept in a hash table
+ * of chains which doubles its number of buckets when the average chain
+ * gets longer than two. Each atom is allocated with its length, hash and
+ * reference count stored in front of the string. The atom is removed when
+ * the last reference is released and the table when the last atom is gone.
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/* ----------------------------------------------------------- Definitions */
+
+
+#define INITIAL_BUCKETS 256
+
+typedef struct atom_t {
+        struct atom_t *link;
+        unsigned int hash;
+        int length;
+        int refs;
+        char str[];
+} *atom_t;
+
+static struct {
+        int count;
+        int buckets;
+        long size;
+        atom_t *table;
+} _atoms = {};
+
+static Mutex_T _mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* --------------------------------------------------------------- Private */
+
+
+// FNV-1a
+static unsigned int _hash(const char *s, int length) {
+        unsigned int h = 2166136261U;
+        for (int i = 0; i < length; i++) {
+                h ^= (unsigned char)s[i];
+                h *= 16777619U;
+        }
+        return h;
+}
+
+
+static void _grow() {
+        int buckets = _atoms.buckets ? _atoms.buckets * 2 : INITIAL_BUCKETS;
+        atom_t *table = CALLOC(buckets, sizeof *table);
+        for (int i = 0; i < _atoms.buckets; i++) {
+                for (atom_t a = _atoms.table[i], next; a; a = next) {
+                        next = a->link;
+                        a->link = table[a->hash & (buckets - 1)];
+                        table[a->hash & (buckets - 1)] = a;
+                }
+        }
+        FREE(_atoms.table);
+        _atoms.table = table;
+        _atoms.buckets = buckets;
+}
+
+
+/* ---------------------------------------------------------------- Public */
+
+
+const char *Atom_new(const char *s, int length) {
+        assert(s);
+        assert(length >= 0);
+        unsigned int hash = _hash(s, length);
+        atom_t atom = NULL;
+        LOCK(_mutex)
+        {
+                if (_atoms.table) {
+                        for (atom = _atoms.table[hash & (_atoms.buckets - 1)]; atom; atom = atom->link)
+                                if (atom->hash == hash && atom->length == length && memcmp(atom->str, s, length) == 0)
+                                        break;
+                }
+                if (atom) {
+                        atom->refs++;
+                } else {
+                        if (_atoms.count >= _atoms.buckets * 2)
+                                _grow();
+                        long size = (long)offsetof(struct atom_t, str) + length + 1;
+                        atom = ALLOC(size);
+                        atom->hash = hash;
+                        atom->length = length;
+                        atom->refs = 1;
+                        memcpy(atom->str, s, length);
+                        atom->str[length] = 0;
+                        atom->link = _atoms.table[hash & (_atoms.buckets - 1)];
+                        _atoms.table[hash & (_atoms.buckets - 1)] = atom;
+                        _atoms.count++;
+                        _atoms.size += size;
+                }
+        }
+        END_LOCK;
+        return atom->str;
+}
+
+
+const char *Atom_string(const char *s) {
+        return s ? Atom_new(s, (int)strlen(s)) : NULL;
+}
+
+
+void Atom_free(const char **atom) {
+        assert(atom);
+        if (*atom) {
+                atom_t a = (atom_t)(*atom - offsetof(struct atom_t, str));
+                LOCK(_mutex)
+                {
+                        assert(a->refs > 0);
+                        if (--a->refs == 0) {
+                                atom_t *link = &_atoms.table[a->hash & (_atoms.buckets - 1)];
+                                while (*link != a)
+                                        link = &(*link)->link;
+                                *link = a->link;
+                                _atoms.size -= (long)offsetof(struct atom_t, str) + a->length + 1;
+                                FREE(a);
+                                if (--_atoms.count == 0) {
+                                        FREE(_atoms.table);
+                                        _atoms.buckets = 0;
+                                }
+                        }
+                }
+                END_LOCK;
+                *atom = NULL;
+        }
+}
+
+
+int Atom_length(const char *atom) {
+        assert(atom);
+        return ((atom_t)(atom - offsetof(struct atom_t, str)))->length;
+}
+
+
+void Atom_statistics(int *atoms, long *size) {
+        LOCK(_mutex)
+        {
+                if (atoms)
+                        *atoms = _atoms.count;
+                if (size)
+                        *size = _atoms.size + (long)(_atoms.buckets * sizeof *_atoms.table);
+        }
+        END_LOCK;
+}
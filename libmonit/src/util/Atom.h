@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+
+#ifndef ATOM_INCLUDED
+#define ATOM_INCLUDED
+
+
+/**
+ * An <b>Atom</b> is a pointer to a unique, immutable, null terminated
+ * string. Identical strings are stored once and atoms for them are
+ * the same pointer, so two atoms can be compared with ==. Atoms are
+ * reference counted: each Atom_new() or Atom_string() call returns a
+ * reference which must be released with Atom_free(), and the atom is
+ * deallocated when its last reference is released. Use atoms for
+ * strings which are repeated many times and seldom change, such as
+ * hostnames, mail addresses and group names in a configuration.
+ *
+ * This class is thread-safe
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/**
+ * Returns the atom for the first <code>length</code> bytes of
+ * <code>s</code>. The bytes are copied the first time they are seen,
+ * otherwise the reference count of the existing atom is incremented.
+ * @param s A string. It does not need to be null terminated
+ * @param length The number of bytes in s
+ * @return The atom for s
+ * @exception AssertException if s is NULL or length is negative
+ * @exception MemoryException if allocation failed
+ */
+const char *Atom_new(const char *s, int length);
+
+
+/**
+ * Returns the atom for the null terminated string <code>s</code>
+ * @param s A null terminated string
+ * @return The atom for s or NULL if s is NULL
+ * @exception MemoryException if allocation failed
+ */
+const char *Atom_string(const char *s);
+
+
+/**
+ * Release a reference to the atom. The atom is deallocated when the
+ * last reference is released. The caller must not use the atom after
+ * this call
+ * @param atom A reference to an atom returned by Atom_new() or
+ * Atom_string(). It is set to NULL. Nothing is done if the atom is NULL
+ * @exception AssertException if atom is NULL
+ */
+void Atom_free(const char **atom);
+
+
+/**
+ * Returns the length of an atom. The length is stored with the atom,
+ * so this is a constant time operation
+ * @param atom An atom returned by Atom_new() or Atom_string()
+ * @return The length of the atom in bytes
+ */
+int Atom_length(const char *atom);
+
+
+/**
+ * Get Atom statistics
+ * @param atoms Output: the number of distinct atoms
+ * @param size Output: the number of bytes used by the atoms, including
+ * the hash table
+ */
+void Atom_statistics(int *atoms, long *size);
+
+
+#endif
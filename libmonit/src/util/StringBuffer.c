@@ -29,12 +29,16 @@
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #ifdef HAVE_ZLIB_H
 #include <zlib.h>
 #endif
 
 #include "Str.h"
 #include "StringBuffer.h"
+#include "Thread.h"
 
 
 /**
@@ -55,24 +59,53 @@ struct T {
         int length;
         unsigned char *buffer;
         void *compressedBuffer;
+        T next;
 };
 
 
+// Number of idle buffers kept in the pool
+#define POOL_SIZE 16
+// Buffers which grew beyond this capacity are freed instead of pooled
+#define POOL_MAXLENGTH 1048576
+
+
+static struct {
+        int count;
+        T free;
+} _pool = {};
+static Mutex_T _poolMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
 /* ---------------------------------------------------------------- Private */
 
 
+/* Make room for n more bytes plus the terminating NUL. The capacity is doubled
+ so a long sequence of appends is amortized O(1) */
+static inline void _ensure(T S, int n) {
+        if (S->used + n >= S->length) {
+                int length = S->length * 2;
+                if (length <= S->used + n)
+                        length = S->used + n + 1;
+                S->length = length;
+                RESIZE(S->buffer, S->length);
+        }
+}
+
+
 static inline void _append(T S, const char *s, va_list ap) {
         va_list ap_copy;
-        while (true) {
-                va_copy(ap_copy, ap);
-                int n = vsnprintf((char *)(S->buffer + S->used), S->length - S->used, s, ap_copy);
-                va_end(ap_copy);
-                if ((S->used + n) < S->length) {
-                        S->used += n;
-                        break;
+        va_copy(ap_copy, ap);
+        int n = vsnprintf((char *)(S->buffer + S->used), S->length - S->used, s, ap_copy);
+        va_end(ap_copy);
+        if (n > 0) {
+                if ((S->used + n) >= S->length) {
+                        // Output was truncated, grow and format again (at most once)
+                        _ensure(S, n);
+                        va_copy(ap_copy, ap);
+                        vsnprintf((char *)(S->buffer + S->used), S->length - S->used, s, ap_copy);
+                        va_end(ap_copy);
                 }
-                S->length += STRLEN + n;
-                RESIZE(S->buffer, S->length);
+                S->used += n;
         }
 }
 
@@ -88,6 +121,13 @@ static inline T _ctor(int hint) {
 }
 
 
+static inline void _dtor(T S) {
+        FREE(S->buffer);
+        FREE(S->compressedBuffer);
+        FREE(S);
+}
+
+
 /* ----------------------------------------------------------------- Public */
 
 
@@ -105,9 +145,74 @@ T StringBuffer_create(int hint) {
 
 void StringBuffer_free(T *S) {
         assert(S && *S);
-        FREE((*S)->buffer);
-        FREE((*S)->compressedBuffer);
-        FREE(*S);
+        _dtor(*S);
+        *S = NULL;
+}
+
+
+T StringBuffer_borrow(int hint) {
+        T S = NULL;
+        if (hint <= 0)
+                THROW(AssertException, "Illegal hint value");
+        LOCK(_poolMutex)
+        {
+                if ((S = _pool.free)) {
+                        _pool.free = S->next;
+                        _pool.count--;
+                }
+        }
+        END_LOCK;
+        if (! S)
+                return _ctor(hint);
+        S->next = NULL;
+        if (S->length < hint) {
+                S->length = hint;
+                RESIZE(S->buffer, S->length);
+        }
+        return S;
+}
+
+
+void StringBuffer_release(T *S) {
+        assert(S && *S);
+        T B = *S;
+        *S = NULL;
+        if (B->length <= POOL_MAXLENGTH) {
+                StringBuffer_clear(B);
+                LOCK(_poolMutex)
+                {
+                        if (_pool.count < POOL_SIZE) {
+                                B->next = _pool.free;
+                                _pool.free = B;
+                                _pool.count++;
+                                B = NULL;
+                        }
+                }
+                END_LOCK;
+        }
+        if (B)
+                _dtor(B);
+}
+
+
+T StringBuffer_appendBytes(T S, const void *bytes, int length) {
+        assert(S);
+        if (bytes && length > 0) {
+                _ensure(S, length);
+                memcpy(S->buffer + S->used, bytes, length);
+                S->used += length;
+                S->buffer[S->used] = 0;
+        }
+        return S;
+}
+
+
+T StringBuffer_appendChar(T S, char c) {
+        assert(S);
+        _ensure(S, 1);
+        S->buffer[S->used++] = c;
+        S->buffer[S->used] = 0;
+        return S;
 }
 
 
@@ -152,13 +257,8 @@ int StringBuffer_replace(T S, const char *a, const char *b) {
                         int m = n;
                         size_t bl = strlen(b);
                         size_t diff = bl - strlen(a);
-                        if (diff > 0) {
-                                size_t required = (diff * n) + S->used + 1;
-                                if (required >= S->length) {
-                                        S->length = (int)required;
-                                        RESIZE(S->buffer, S->length);
-                                }
-                        }
+                        if (diff > 0)
+                                _ensure(S, (int)(diff * n));
                         for (i = 0; m; i++) {
                                 if (S->buffer[i] == *a) {
                                         j = 0;
@@ -273,6 +373,14 @@ const char *StringBuffer_toString(T S) {
 }
 
 
+void StringBuffer_toIovec(T S, struct iovec *iov) {
+        assert(S);
+        assert(iov);
+        iov->iov_base = S->buffer;
+        iov->iov_len = S->used;
+}
+
+
 const void *StringBuffer_toCompressed(T S, int level, size_t *length) {
         assert(S);
         assert(length);
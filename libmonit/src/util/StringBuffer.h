@@ -32,7 +32,8 @@
  * Indexing starts at 0 and it is a checked runtime error to access 
  * index out of the range.
  *
- * This class is reentrant but not thread-safe
+ * This class is reentrant but not thread-safe. The buffer pool used by
+ * StringBuffer_borrow() and StringBuffer_release() is thread-safe.
  *
  * @author http://www.tildeslash.com/
  * @see http://www.mmonit.com/
@@ -42,6 +43,7 @@
 
 #define T StringBuffer_T
 typedef struct T *T;
+struct iovec;
 
 
 /**
@@ -72,6 +74,28 @@ T StringBuffer_create(int hint);
 void StringBuffer_free(T *S);
 
 
+/**
+ * Borrow an empty string buffer from the process-wide buffer pool. If
+ * the pool is empty a new buffer is created. The buffer must be given
+ * back with StringBuffer_release() so its storage can be reused by the
+ * next borrower instead of being reallocated and grown again.
+ * @param hint The minimum initial capacity of the buffer in bytes (hint > 0)
+ * @return An empty StringBuffer object
+ * @exception AssertException if hint is less than or equal to 0
+ * @exception MemoryException if allocation failed
+ */
+T StringBuffer_borrow(int hint);
+
+
+/**
+ * Return a string buffer to the buffer pool. The buffer is cleared and
+ * kept for reuse, unless the pool is full or the buffer grew very large
+ * in which case it is freed. The reference is set to NULL.
+ * @param S A StringBuffer object reference
+ */
+void StringBuffer_release(T *S);
+
+
 /**
  * The characters of the String argument are appended, in order, to the 
  * contents of this string buffer, increasing the length of this string 
@@ -84,6 +108,29 @@ void StringBuffer_free(T *S);
 T StringBuffer_append(T S, const char *s, ...) __attribute__((format (printf, 2, 3)));
 
 
+/**
+ * Append <code>length</code> bytes from <code>bytes</code> to this string
+ * buffer as is, without formatting. Use this method instead of
+ * StringBuffer_append(S, "%s", s) for raw data or when the length is known.
+ * @param S StringBuffer object
+ * @param bytes The data to append. If NULL, nothing is appended
+ * @param length The number of bytes to append
+ * @return a reference to this StringBuffer
+ * @exception MemoryException if allocation was used and failed
+ */
+T StringBuffer_appendBytes(T S, const void *bytes, int length);
+
+
+/**
+ * Append a single character to this string buffer, without formatting.
+ * @param S StringBuffer object
+ * @param c The character to append
+ * @return a reference to this StringBuffer
+ * @exception MemoryException if allocation was used and failed
+ */
+T StringBuffer_appendChar(T S, char c);
+
+
 /**
  * The characters of the String argument are appended, in order, to the 
  * contents of this string buffer, increasing the length of this string 
@@ -206,6 +253,16 @@ T StringBuffer_clear(T S);
 const char *StringBuffer_toString(T S);
 
 
+/**
+ * Describe the content of this string buffer in an iovec structure so it
+ * can be written with writev(2) together with other data without copying.
+ * The iovec is valid until the buffer is modified or freed.
+ * @param S StringBuffer object
+ * @param iov The iovec to set to the buffer data and length
+ */
+void StringBuffer_toIovec(T S, struct iovec *iov);
+
+
 /**
  * Returns the content of this string buffer as gzip compressed data (binary data).
  * @param S StringBuffer object
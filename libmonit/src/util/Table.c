@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#include "Config.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "Table.h"
+
+
+/**
+ * Implementation of the Table interface. The entries are kept in
+ * separately chained buckets and the bucket array is doubled when the
+ * number of entries exceeds the number of buckets.
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+/* ----------------------------------------------------------- Definitions */
+
+
+#define T Table_T
+
+#define TABLE_MIN_SIZE 16
+
+typedef struct binding_t {
+        const void *key;
+        void *value;
+        unsigned int hash;
+        struct binding_t *next;
+} *binding_t;
+
+struct T {
+        int size;
+        int length;
+        int (*cmp)(const void *x, const void *y);
+        unsigned int (*hash)(const void *key);
+        binding_t *buckets;
+};
+
+
+/* --------------------------------------------------------------- Private */
+
+
+static int _cmpAtom(const void *x, const void *y) {
+        return x != y;
+}
+
+
+static unsigned int _hashAtom(const void *key) {
+        return (unsigned int)((uintptr_t)key >> 2);
+}
+
+
+static inline binding_t *_find(T t, const void *key, unsigned int hash) {
+        binding_t *p = &t->buckets[hash & (t->size - 1)];
+        for (; *p; p = &(*p)->next)
+                if ((*p)->hash == hash && t->cmp(key, (*p)->key) == 0)
+                        break;
+        return p;
+}
+
+
+static void _grow(T t) {
+        int size = t->size * 2;
+        binding_t *buckets = CALLOC(size, sizeof *(buckets));
+        for (int i = 0; i < t->size; i++) {
+                for (binding_t p = t->buckets[i], q; p; p = q) {
+                        q = p->next;
+                        p->next = buckets[p->hash & (size - 1)];
+                        buckets[p->hash & (size - 1)] = p;
+                }
+        }
+        FREE(t->buckets);
+        t->buckets = buckets;
+        t->size = size;
+}
+
+
+/* ---------------------------------------------------------------- Public */
+
+
+T Table_new(int hint, int cmp(const void *x, const void *y), unsigned int hash(const void *key)) {
+        T t;
+        assert(hint >= 0);
+        NEW(t);
+        t->cmp = cmp ? cmp : _cmpAtom;
+        t->hash = hash ? hash : _hashAtom;
+        for (t->size = TABLE_MIN_SIZE; t->size < hint; t->size *= 2)
+                ;
+        t->buckets = CALLOC(t->size, sizeof *(t->buckets));
+        return t;
+}
+
+
+void Table_free(T *t) {
+        assert(t && *t);
+        Table_clear(*t);
+        FREE((*t)->buckets);
+        FREE(*t);
+}
+
+
+void *Table_put(T t, const void *key, void *value) {
+        assert(t);
+        assert(key);
+        unsigned int hash = t->hash(key);
+        binding_t *p = _find(t, key, hash);
+        if (*p) {
+                void *prev = (*p)->value;
+                (*p)->value = value;
+                return prev;
+        }
+        binding_t b;
+        NEW(b);
+        b->key = key;
+        b->value = value;
+        b->hash = hash;
+        b->next = t->buckets[hash & (t->size - 1)];
+        t->buckets[hash & (t->size - 1)] = b;
+        if (++t->length > t->size)
+                _grow(t);
+        return NULL;
+}
+
+
+void *Table_get(T t, const void *key) {
+        assert(t);
+        assert(key);
+        binding_t *p = _find(t, key, t->hash(key));
+        return *p ? (*p)->value : NULL;
+}
+
+
+void *Table_remove(T t, const void *key) {
+        assert(t);
+        assert(key);
+        binding_t *p = _find(t, key, t->hash(key));
+        if (*p) {
+                binding_t b = *p;
+                void *value = b->value;
+                *p = b->next;
+                FREE(b);
+                t->length--;
+                return value;
+        }
+        return NULL;
+}
+
+
+int Table_length(T t) {
+        assert(t);
+        return t->length;
+}
+
+
+void Table_map(T t, void apply(const void *key, void **value, void *ap), void *ap) {
+        assert(t);
+        assert(apply);
+        for (int i = 0; i < t->size; i++)
+                for (binding_t p = t->buckets[i]; p; p = p->next)
+                        apply(p->key, &p->value, ap);
+}
+
+
+void Table_clear(T t) {
+        assert(t);
+        for (int i = 0; i < t->size; i++) {
+                for (binding_t p = t->buckets[i], q; p; p = q) {
+                        q = p->next;
+                        FREE(p);
+                }
+                t->buckets[i] = NULL;
+        }
+        t->length = 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.  
+ */
+
+
+
+#ifndef TABLE_INCLUDED
+#define TABLE_INCLUDED
+
+
+/**
+ * A <b>Table</b> is an associative array which maps keys to values.
+ * Keys are compared with the <code>cmp</code> function and hashed with
+ * the <code>hash</code> function given to Table_new(), for example
+ * Str_cmp() and Str_hash() for string keys. If these functions are NULL,
+ * keys are compared and hashed by their address. Table_put(),
+ * Table_get() and Table_remove() run in constant expected time; the
+ * bucket array grows when the Table fills, so lookups stay fast
+ * regardless of the number of entries.
+ *
+ * The Table does not copy nor free keys and values, the caller owns
+ * them and must keep a key valid while it is in the Table.
+ *
+ * This class is reentrant but not thread-safe
+ *
+ * @author http://www.tildeslash.com/
+ * @see http://www.mmonit.com/
+ * @file
+ */
+
+
+#define T Table_T
+typedef struct T *T;
+
+
+/**
+ * Create a new Table object.
+ * @param hint Estimated number of entries, used to size the initial
+ * bucket array
+ * @param cmp Key comparison function returning 0 if the keys are equal,
+ * or NULL to compare the key addresses
+ * @param hash Key hash function, or NULL to hash the key addresses
+ * @return A Table object
+ * @exception MemoryException if allocation failed
+ */
+T Table_new(int hint, int cmp(const void *x, const void *y), unsigned int hash(const void *key));
+
+
+/**
+ * Destroy a Table object and release allocated resources. The keys
+ * and values are not freed.
+ * @param t A Table object reference
+ */
+void Table_free(T *t);
+
+
+/**
+ * Add the <code>key</code> - <code>value</code> pair to the Table. If
+ * the Table contains the key already, its value is replaced.
+ * @param t A Table object
+ * @param key The key
+ * @param value The value
+ * @return The previous value of the key or NULL if the key was not in
+ * the Table
+ * @exception MemoryException if allocation failed
+ */
+void *Table_put(T t, const void *key, void *value);
+
+
+/**
+ * Get the value of the <code>key</code>
+ * @param t A Table object
+ * @param key The key to find
+ * @return The value of the key or NULL if the key is not in the Table
+ */
+void *Table_get(T t, const void *key);
+
+
+/**
+ * Remove the <code>key</code> from the Table
+ * @param t A Table object
+ * @param key The key to remove
+ * @return The value of the removed key or NULL if the key was not in
+ * the Table
+ */
+void *Table_remove(T t, const void *key);
+
+
+/**
+ * Returns the number of entries in the Table.
+ * @param t A Table object
+ * @return Number of entries in the Table
+ */
+int Table_length(T t);
+
+
+/**
+ * Call the <code>apply</code> function for each entry in the Table
+ * in unspecified order. The Table must not be modified by the
+ * <code>apply</code> function.
+ * @param t A Table object
+ * @param apply The function to call with the key, a pointer to the
+ * value (the value may be changed) and the <code>ap</code> argument
+ * @param ap Argument passed to the <code>apply</code> function
+ */
+void Table_map(T t, void apply(const void *key, void **value, void *ap), void *ap);
+
+
+/**
+ * Remove all entries from the Table. The keys and values are not freed.
+ * @param t A Table object
+ */
+void Table_clear(T t);
+
+
+#undef T
+#endif
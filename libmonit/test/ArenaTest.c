@@ -0,0 +1,86 @@
+#include "Config.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Bootstrap.h"
+#include "Str.h"
+#include "Arena.h"
+
+/**
+ * Arena.c unity tests.
+ */
+
+
+int main(void) {
+        Arena_T A = NULL;
+
+        Bootstrap(); // Need to initialize library
+
+        printf("============> Start Arena Tests\n\n");
+
+        printf("=> Test0: create/destroy\n");
+        {
+                A = Arena_new(1024);
+                assert(A);
+                assert(Arena_used(A) == 0);
+                Arena_free(&A);
+                assert(A == NULL);
+                TRY
+                {
+                        Arena_new(0);
+                        printf("\t Test Failed\n");
+                        exit(1);
+                }
+                CATCH (AssertException)
+                END_TRY;
+        }
+        printf("=> Test0: OK\n\n");
+
+        printf("=> Test1: Arena_alloc() & Arena_calloc()\n");
+        {
+                A = Arena_new(256);
+                char *a = Arena_alloc(A, 3, __func__, __FILE__, __LINE__);
+                memcpy(a, "ab", 3);
+                long long *b;
+                ARENA_NEW(A, b);
+                assert(*b == 0);
+                assert(((uintptr_t)b % sizeof(long long)) == 0);
+                assert((char *)b > a && (char *)b - a < 64); // Contiguous
+                int *c = Arena_calloc(A, 10, sizeof(int), __func__, __FILE__, __LINE__);
+                for (int i = 0; i < 10; i++)
+                        assert(c[i] == 0);
+                assert(Str_isEqual(a, "ab"));
+                assert(Arena_used(A) == 3 + sizeof(long long) + 10 * sizeof(int));
+                Arena_free(&A);
+        }
+        printf("=> Test1: OK\n\n");
+
+        printf("=> Test2: many and large objects\n");
+        {
+                A = Arena_new(128);
+                char *small = Arena_alloc(A, 8, __func__, __FILE__, __LINE__);
+                char *large = Arena_alloc(A, 10000, __func__, __FILE__, __LINE__);
+                memset(large, 'x', 10000);
+                char *next = Arena_alloc(A, 8, __func__, __FILE__, __LINE__);
+                assert(next > small && next - small < 128); // The current chunk is still used after a large object
+                void *p[1000];
+                for (int i = 0; i < 1000; i++) {
+                        p[i] = Arena_alloc(A, 24, __func__, __FILE__, __LINE__);
+                        memset(p[i], i % 256, 24);
+                }
+                for (int i = 0; i < 1000; i++)
+                        assert(((unsigned char *)p[i])[23] == i % 256);
+                assert(large[9999] == 'x');
+                assert(Arena_size(A) >= Arena_used(A));
+                Arena_free(&A);
+        }
+        printf("=> Test2: OK\n\n");
+
+        printf("============> Arena Tests: OK\n\n");
+
+        return 0;
+}
@@ -0,0 +1,127 @@
+#include "Config.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "Bootstrap.h"
+#include "Str.h"
+#include "Atom.h"
+
+/**
+ * Atom.c unity tests.
+ */
+
+
+int main(void) {
+
+        Bootstrap(); // Need to initialize library
+
+        printf("============> Start Atom Tests\n\n");
+
+        printf("=> Test0: Atom_string()\n");
+        {
+                char a[] = "mail@example.com";
+                char b[] = "mail@example.com";
+                const char *x = Atom_string(a);
+                const char *y = Atom_string(b);
+                assert(x == y);
+                assert(x != a && x != b);
+                assert(Str_isEqual(x, "mail@example.com"));
+                assert(Atom_string("example.com") != x);
+                assert(Atom_string("") == Atom_string(""));
+                assert(Atom_string(NULL) == NULL);
+        }
+        printf("=> Test0: OK\n\n");
+
+        printf("=> Test1: Atom_new() & Atom_length()\n");
+        {
+                const char *x = Atom_new("localhost:2812", 9);
+                assert(x == Atom_string("localhost"));
+                assert(Atom_length(x) == 9);
+                assert(Atom_length(Atom_string("")) == 0);
+                const char *y = Atom_new("a\0b", 3);
+                assert(y != Atom_string("a"));
+                assert(Atom_length(y) == 3);
+                assert(memcmp(y, "a\0b", 4) == 0);
+                TRY
+                {
+                        Atom_new(NULL, 1);
+                        printf("\t Test Failed\n");
+                        exit(1);
+                }
+                CATCH (AssertException)
+                END_TRY;
+        }
+        printf("=> Test1: OK\n\n");
+
+        printf("=> Test2: many atoms\n");
+        {
+                int count;
+                long size;
+                Atom_statistics(&count, &size);
+                const char *atoms[5000];
+                for (int i = 0; i < 5000; i++) {
+                        char s[32];
+                        snprintf(s, sizeof(s), "host%d.example.com", i);
+                        atoms[i] = Atom_string(s);
+                }
+                for (int i = 0; i < 5000; i++) {
+                        char s[32];
+                        snprintf(s, sizeof(s), "host%d.example.com", i);
+                        assert(Atom_string(s) == atoms[i]);
+                        assert(Atom_length(atoms[i]) == (int)strlen(s));
+                }
+                int count2;
+                long size2;
+                Atom_statistics(&count2, &size2);
+                assert(count2 == count + 5000);
+                assert(size2 > size);
+                for (int i = 0; i < 5000; i++) {
+                        const char *x = atoms[i];
+                        Atom_free(&atoms[i]);
+                        Atom_free(&x);
+                }
+                Atom_statistics(&count2, NULL);
+                assert(count2 == count);
+        }
+        printf("=> Test2: OK\n\n");
+
+        printf("=> Test3: Atom_free()\n");
+        {
+                int count, count2;
+                long size, size2;
+                Atom_statistics(&count, &size);
+                const char *x = Atom_string("reload.example.com");
+                const char *y = Atom_string("reload.example.com");
+                assert(x == y);
+                Atom_statistics(&count2, NULL);
+                assert(count2 == count + 1);
+                // The atom lives until the last reference is released
+                Atom_free(&x);
+                assert(x == NULL);
+                assert(Str_isEqual(y, "reload.example.com"));
+                x = Atom_string("reload.example.com");
+                assert(x == y);
+                Atom_free(&x);
+                Atom_free(&y);
+                Atom_free(&y); // NULL atom is ignored
+                Atom_statistics(&count2, &size2);
+                assert(count2 == count);
+                assert(size2 == size);
+                TRY
+                {
+                        Atom_free(NULL);
+                        printf("\t Test Failed\n");
+                        exit(1);
+                }
+                CATCH (AssertException)
+                END_TRY;
+        }
+        printf("=> Test3: OK\n\n");
+
+        printf("============> Atom Tests: OK\n\n");
+
+        return 0;
+}
@@ -0,0 +1,112 @@
+#include "Config.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Bootstrap.h"
+#include "Str.h"
+#include "FileCache.h"
+
+/**
+ * FileCache.c unity tests.
+ */
+
+
+static void _write(const char *path, const char *content) {
+        FILE *f = fopen(path, "w");
+        assert(f);
+        assert(fputs(content, f) >= 0);
+        assert(fclose(f) == 0);
+}
+
+
+int main(void) {
+        char path[STRLEN];
+        char buf[STRLEN];
+        int files;
+        unsigned long long reads, opens;
+
+        Bootstrap(); // Need to initialize library
+
+        printf("============> Start FileCache Tests\n\n");
+
+        snprintf(path, STRLEN, "/tmp/.FileCacheTest.%d", getpid());
+
+        printf("=> Test1: read\n");
+        {
+                _write(path, "123 456");
+                assert(FileCache_read(path, buf, sizeof(buf)) == 7);
+                assert(Str_isEqual(buf, "123 456"));
+                FileCache_statistics(&files, &reads, &opens);
+                assert(files == 1);
+                assert(reads == 1);
+                assert(opens == 1);
+        }
+        printf("=> Test1: OK\n\n");
+
+        printf("=> Test2: re-read with the cached descriptor\n");
+        {
+                _write(path, "789");
+                assert(FileCache_read(path, buf, sizeof(buf)) == 3);
+                assert(Str_isEqual(buf, "789"));
+                // Truncated read, NUL terminated
+                assert(FileCache_read(path, buf, 3) == 2);
+                assert(Str_isEqual(buf, "78"));
+                FileCache_statistics(&files, &reads, &opens);
+                assert(files == 1);
+                assert(reads == 3);
+                assert(opens == 1);
+        }
+        printf("=> Test2: OK\n\n");
+
+        printf("=> Test3: readAll\n");
+        {
+                char *b = NULL;
+                size_t size = 0;
+                char big[10001];
+                memset(big, 'x', 10000);
+                big[10000] = 0;
+                _write(path, big);
+                assert(FileCache_readAll(path, &b, &size) == 10000);
+                assert(size > 10000);
+                assert(Str_isEqual(b, big));
+                _write(path, "abc");
+                assert(FileCache_readAll(path, &b, &size) == 3);
+                assert(Str_isEqual(b, "abc"));
+                FREE(b);
+                FileCache_statistics(&files, NULL, &opens);
+                assert(files == 1);
+                assert(opens == 1);
+        }
+        printf("=> Test3: OK\n\n");
+
+        printf("=> Test4: clear\n");
+        {
+                FileCache_clear();
+                FileCache_statistics(&files, NULL, NULL);
+                assert(files == 0);
+                assert(FileCache_read(path, buf, sizeof(buf)) == 3);
+                FileCache_statistics(&files, NULL, &opens);
+                assert(files == 1);
+                assert(opens == 2);
+        }
+        printf("=> Test4: OK\n\n");
+
+        printf("=> Test5: missing file\n");
+        {
+                FileCache_clear();
+                assert(unlink(path) == 0);
+                assert(FileCache_read(path, buf, sizeof(buf)) == -1);
+                assert(errno == ENOENT);
+                FileCache_statistics(&files, NULL, NULL);
+                assert(files == 0);
+        }
+        printf("=> Test5: OK\n\n");
+
+        printf("============> FileCache Tests: OK\n\n");
+
+        return 0;
+}
+
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 
 #include "Bootstrap.h"
 #include "Str.h"
@@ -388,6 +389,59 @@ int main(void) {
         }
         printf("=> Test15: OK\n\n");
 #endif
+
+        printf("=> Test16: appendBytes/appendChar and growth\n");
+        {
+                sb = StringBuffer_create(1);
+                StringBuffer_appendChar(sb, 'a');
+                StringBuffer_appendBytes(sb, "bcdef", 3);
+                StringBuffer_appendBytes(sb, NULL, 10);
+                assert(Str_isEqual(StringBuffer_toString(sb), "abcd"));
+                for (int i = 0; i < 100000; i++)
+                        StringBuffer_append(sb, "%d", i % 10);
+                assert(StringBuffer_length(sb) == 100004);
+                assert(StringBuffer_toString(sb)[100003] == '9');
+                StringBuffer_clear(sb);
+                char big[5000];
+                memset(big, 'x', sizeof(big) - 1);
+                big[sizeof(big) - 1] = 0;
+                StringBuffer_append(sb, "<%s>", big);
+                assert(StringBuffer_length(sb) == 5001);
+                assert(StringBuffer_toString(sb)[5000] == '>');
+                StringBuffer_free(&sb);
+        }
+        printf("=> Test16: OK\n\n");
+
+        printf("=> Test17: borrow/release\n");
+        {
+                sb = StringBuffer_borrow(64);
+                StringBuffer_append(sb, "hello");
+                StringBuffer_T saved = sb;
+                StringBuffer_release(&sb);
+                assert(sb == NULL);
+                sb = StringBuffer_borrow(16);
+                assert(sb == saved);
+                assert(StringBuffer_length(sb) == 0);
+                StringBuffer_T other = StringBuffer_borrow(1024);
+                assert(other != sb);
+                StringBuffer_append(other, "world");
+                assert(Str_isEqual(StringBuffer_toString(other), "world"));
+                StringBuffer_release(&other);
+                StringBuffer_release(&sb);
+        }
+        printf("=> Test17: OK\n\n");
+
+        printf("=> Test18: toIovec\n");
+        {
+                struct iovec iov;
+                sb = StringBuffer_new("abc");
+                StringBuffer_toIovec(sb, &iov);
+                assert(iov.iov_len == 3);
+                assert(memcmp(iov.iov_base, "abc", 3) == 0);
+                StringBuffer_free(&sb);
+        }
+        printf("=> Test18: OK\n\n");
+
         printf("============> StringBuffer Tests: OK\n\n");
 
         return 0;
@@ -0,0 +1,121 @@
+#include "Config.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "Bootstrap.h"
+#include "Str.h"
+#include "Table.h"
+
+/**
+ * Table.c unity tests.
+ */
+
+
+static void count(const void *key, void **value, void *ap) {
+        (*(int *)ap)++;
+        *value = "x";
+}
+
+
+int main(void) {
+        Table_T T = NULL;
+
+        Bootstrap(); // Need to initialize library
+
+        printf("============> Start Table Tests\n\n");
+
+        printf("=> Test0: create\n");
+        {
+                T = Table_new(0, Str_cmp, Str_hash);
+                assert(T);
+                assert(Table_length(T) == 0);
+                Table_free(&T);
+                assert(T == NULL);
+        }
+        printf("=> Test0: OK\n\n");
+
+        printf("=> Test1: Table_put() & Table_get()\n");
+        {
+                T = Table_new(10, Str_cmp, Str_hash);
+                assert(Table_put(T, "apache", "1") == NULL);
+                assert(Table_put(T, "mysql", "2") == NULL);
+                assert(Table_put(T, "nginx", "3") == NULL);
+                assert(Table_length(T) == 3);
+                char key[] = "mysql"; // Different address, same content
+                assert(Str_isEqual(Table_get(T, key), "2"));
+                assert(Str_isEqual(Table_get(T, "apache"), "1"));
+                assert(Table_get(T, "postgres") == NULL);
+                // Replace value
+                assert(Str_isEqual(Table_put(T, "nginx", "4"), "3"));
+                assert(Str_isEqual(Table_get(T, "nginx"), "4"));
+                assert(Table_length(T) == 3);
+        }
+        printf("=> Test1: OK\n\n");
+
+        printf("=> Test2: Table_remove()\n");
+        {
+                assert(Str_isEqual(Table_remove(T, "mysql"), "2"));
+                assert(Table_remove(T, "mysql") == NULL);
+                assert(Table_get(T, "mysql") == NULL);
+                assert(Table_length(T) == 2);
+                Table_free(&T);
+        }
+        printf("=> Test2: OK\n\n");
+
+        printf("=> Test3: grow\n");
+        {
+                char keys[10000][16];
+                T = Table_new(0, Str_cmp, Str_hash);
+                for (int i = 0; i < 10000; i++) {
+                        snprintf(keys[i], sizeof(keys[i]), "service%d", i);
+                        Table_put(T, keys[i], keys[i]);
+                }
+                assert(Table_length(T) == 10000);
+                for (int i = 0; i < 10000; i++) {
+                        char key[16];
+                        snprintf(key, sizeof(key), "service%d", i);
+                        assert(Table_get(T, key) == keys[i]);
+                }
+                Table_free(&T);
+        }
+        printf("=> Test3: OK\n\n");
+
+        printf("=> Test4: Table_map() & Table_clear()\n");
+        {
+                int n = 0;
+                T = Table_new(0, Str_cmp, Str_hash);
+                Table_put(T, "a", "1");
+                Table_put(T, "b", "2");
+                Table_put(T, "c", "3");
+                Table_map(T, count, &n);
+                assert(n == 3);
+                assert(Str_isEqual(Table_get(T, "b"), "x"));
+                Table_clear(T);
+                assert(Table_length(T) == 0);
+                assert(Table_get(T, "a") == NULL);
+                Table_put(T, "a", "1");
+                assert(Table_length(T) == 1);
+                Table_free(&T);
+        }
+        printf("=> Test4: OK\n\n");
+
+        printf("=> Test5: address keys\n");
+        {
+                int a, b;
+                T = Table_new(0, NULL, NULL);
+                Table_put(T, &a, "a");
+                Table_put(T, &b, "b");
+                assert(Str_isEqual(Table_get(T, &a), "a"));
+                assert(Str_isEqual(Table_get(T, &b), "b"));
+                Table_free(&T);
+        }
+        printf("=> Test5: OK\n\n");
+
+        printf("============> Table Tests: OK\n\n");
+
+        return 0;
+}
+
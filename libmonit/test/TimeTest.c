@@ -282,6 +282,60 @@ int main(void) {
         }
         printf("=> Test9: OK\n\n");
 
+        printf("=> Test10: Time_monotonic\n");
+        {
+                long long t1 = Time_monotonic();
+                assert(t1 > 0);
+                Time_usleep(100000);
+                long long t2 = Time_monotonic();
+                assert(t2 - t1 >= 100);
+                assert(t2 - t1 < 1000);
+                long long m1 = Time_monotonicMicro();
+                Time_usleep(10000);
+                long long m2 = Time_monotonicMicro();
+                assert(m2 - m1 >= 10000);
+                assert(m2 / 1000 - Time_monotonic() <= 1);
+        }
+        printf("=> Test10: OK\n\n");
+
+        printf("=> Test11: Time_cronCompile/Time_cronMatch/Time_cronNext\n");
+        {
+                TimeCron_T spec;
+                const char *valid[] = {"27 11 5 7 2", "* * * * *", "* 10-11 1-5 * 1-5", "1-10 9-10 1-5 * 1-5", "* 10,11 1-3,5,6 * *", "* 10,11,12 4,5,6 * 0,6", "0 0 1, 15 * *"};
+                const char *invalid[] = {"a bc d", "* * * *  ", "* * * * * * ", "60 * * * *", "* 24 * * *", "* * 0 * *", "* * * 13 *", "* * * * 8", "* 9-8 * * *", "*/5 * * * *", "1- * * * *", ""};
+                for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+                        assert(! Time_cronCompile(invalid[i], &spec));
+                // The compiled specification matches the same times as Time_incron
+                time_t start = Time_build(2011, 7, 5, 11, 27, 5);
+                for (int i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+                        assert(Time_cronCompile(valid[i], &spec));
+                        for (time_t t = start; t < start + 8 * 86400; t += 7 * 60 + 13)
+                                assert(Time_cronMatch(&spec, t) == Time_incron(valid[i], t));
+                }
+                assert(Time_cronCompile("0 12 * * *", &spec));
+                assert(Time_cronNext(&spec, start) == Time_build(2011, 7, 5, 12, 0, 0));
+                assert(Time_cronNext(&spec, Time_build(2011, 7, 5, 12, 0, 0)) == Time_build(2011, 7, 6, 12, 0, 0));
+                assert(Time_cronCompile("* * * * *", &spec));
+                assert(Time_cronNext(&spec, start) == Time_build(2011, 7, 5, 11, 28, 0));
+                assert(Time_cronCompile("30 2 1 1 *", &spec));
+                assert(Time_cronNext(&spec, start) == Time_build(2012, 1, 1, 2, 30, 0));
+                assert(Time_cronCompile("0 0 13 * 5", &spec)); // Friday the 13th
+                assert(Time_cronNext(&spec, start) == Time_build(2012, 1, 13, 0, 0, 0));
+                assert(Time_cronCompile("0 0 29 2 *", &spec));
+                assert(Time_cronNext(&spec, start) == Time_build(2012, 2, 29, 0, 0, 0));
+                assert(Time_cronCompile("0 0 30 2 *", &spec));
+                assert(Time_cronNext(&spec, start) == 0);
+                // Weekday 7 is Sunday, same as 0
+                assert(Time_cronCompile("0 0 * * 7", &spec));
+                assert(spec.weekdays == 1);
+                assert(Time_cronNext(&spec, start) == Time_build(2011, 7, 10, 0, 0, 0));
+                assert(Time_cronCompile("0 0 * * 5-7", &spec));
+                assert(spec.weekdays == (1 | 1 << 5 | 1 << 6));
+                assert(Time_cronCompile("* * * * *", &spec));
+                assert(spec.weekdays == 0x7f);
+        }
+        printf("=> Test11: OK\n\n");
+
         printf("============> Time Tests: OK\n\n");
 
         return 0;
@@ -6,12 +6,16 @@ StrTest && \
 TimeTest && \
 SystemTest && \
 ListTest && \
+TableTest && \
+ArenaTest && \
+AtomTest && \
 LinkTest && \
 StringBufferTest && \
 DirTest && \
 InputStreamTest && \
 OutputStreamTest && \
 FileTest && \
+FileCacheTest && \
 ExceptionTest && \
 NetTest && \
 CommandTest
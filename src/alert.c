@@ -148,7 +148,7 @@ static void _copyMail(Mail_T n, Mail_T o) {
         ASSERT(n);
         ASSERT(o);
 
-        n->to = Str_dup(o->to);
+        n->to = Atom_string(o->to);
         if (o->from) {
                 n->from = Address_copy(o->from);
         } else if (Run.MailFormat.from) {
@@ -275,9 +275,12 @@ static boolean_t _send(List_T list) {
 }
 
 
+/**
+ * Mail addresses are atoms, so they are compared by pointer
+ */
 boolean_t _hasRecipient(Mail_T list, const char *recipient) {
         for (Mail_T l = list; l; l = l->next)
-                if (IS(recipient, l->to))
+                if (recipient == l->to)
                         return true;
         return false;
 }
@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#endif
+
+#include "monit.h"
+#include "net.h"
+#include "bench.h"
+
+// libmonit
+#include "system/Time.h"
+#include "system/Net.h"
+#include "io/File.h"
+#include "io/Dir.h"
+#include "exceptions/AssertException.h"
+
+
+/**
+ * Implementation of the benchmark mode, see bench.h
+ *
+ * @file
+ */
+
+
+/* ------------------------------------------------------------- Definitions */
+
+
+typedef struct Usage_T {
+        long long time;                               /**< Monotonic time [us] */
+        unsigned long long allocations;               /**< Memory allocations */
+        unsigned long long frees;                   /**< Memory deallocations */
+        long long user;                                    /**< User CPU [us] */
+        long long system;                                /**< System CPU [us] */
+        long long voluntary;                 /**< Voluntary context switches */
+        long long involuntary;             /**< Involuntary context switches */
+        long long syscr;                               /**< Read system calls */
+        long long syscw;                              /**< Write system calls */
+        long long cachemisses;         /**< Hardware cache misses, -1 if unknown */
+} Usage_T;
+
+
+/* Number of the fixture services per type */
+#define FIXTURE_FILES 20
+#define FIXTURE_SERVERS 4
+
+
+typedef struct Server_T {
+        int socket;                                  /**< Listening socket */
+        int port;                               /**< Ephemeral loopback port */
+        Thread_T thread;                              /**< The server thread */
+} Server_T;
+
+
+static struct {
+        volatile boolean_t running;          /**< The mock servers are running */
+        pid_t pid;                           /**< The process which owns them */
+        char *dir;                                 /**< The fixture directory */
+        int servers;                         /**< Number of started servers */
+        Server_T server[FIXTURE_SERVERS];
+} _fixtures = {};
+
+
+#if defined HAVE_LINUX_PERF_EVENT_H && defined SYS_perf_event_open
+static int _cachemisses = -1; // perf event counter descriptor
+#endif
+
+
+/* ----------------------------------------------------------------- Private */
+
+
+/**
+ * Mock TCP server for the port tests: the connection test closes the connection without sending
+ * anything, the send/expect test gets a "PONG" answer to any request
+ */
+static void *_server(void *args) {
+        Server_T *server = args;
+        set_signal_block();
+        while (_fixtures.running) {
+                if (Net_canRead(server->socket, 100)) {
+                        int client = accept(server->socket, NULL, NULL);
+                        if (client >= 0) {
+                                char request[STRLEN];
+                                Net_setNonBlocking(client);
+                                if (Net_read(client, request, sizeof(request), 1000) > 0)
+                                        Net_write(client, "PONG\r\n", 6, 1000);
+                                Net_close(client);
+                        }
+                }
+        }
+        return NULL;
+}
+
+
+static boolean_t _serverStart(Server_T *server) {
+        char error[STRLEN];
+        if ((server->socket = create_server_socket_tcp("127.0.0.1", 0, Socket_Ip4, 16, error)) < 0) {
+                LogError("Benchmark: cannot create a mock server -- %s\n", error);
+                return false;
+        }
+        struct sockaddr_in addr;
+        socklen_t addrlen = sizeof(addr);
+        if (getsockname(server->socket, (struct sockaddr *)&addr, &addrlen) != 0) {
+                LogError("Benchmark: cannot get the mock server port -- %s\n", STRERROR);
+                Net_close(server->socket);
+                return false;
+        }
+        server->port = ntohs(addr.sin_port);
+        Thread_create(server->thread, _server, server);
+        return true;
+}
+
+
+static boolean_t _write(const char *path, const char *content) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+                LogError("Benchmark: cannot create %s -- %s\n", path, STRERROR);
+                return false;
+        }
+        size_t length = strlen(content);
+        boolean_t rv = write(fd, content, length) == (ssize_t)length;
+        if (! rv)
+                LogError("Benchmark: cannot write %s -- %s\n", path, STRERROR);
+        close(fd);
+        return rv;
+}
+
+
+/**
+ * Stop the mock servers and remove the fixture directory. Registered with atexit(), so the
+ * fixtures are removed on any exit path; the forked children must not touch them
+ */
+static void _fixturesRemove() {
+        if (! _fixtures.dir || _fixtures.pid != getpid())
+                return;
+        _fixtures.running = false;
+        for (int i = 0; i < _fixtures.servers; i++) {
+                Thread_join(_fixtures.server[i].thread);
+                Net_close(_fixtures.server[i].socket);
+        }
+        _fixtures.servers = 0;
+        DIR *d = opendir(_fixtures.dir);
+        if (d) {
+                struct dirent *e;
+                while ((e = readdir(d))) {
+                        if (! IS(e->d_name, ".") && ! IS(e->d_name, "..")) {
+                                char path[PATH_MAX];
+                                snprintf(path, sizeof(path), "%s/%s", _fixtures.dir, e->d_name);
+                                File_delete(path);
+                        }
+                }
+                closedir(d);
+        }
+        if (! Dir_delete(_fixtures.dir))
+                LogError("Benchmark: cannot remove the fixture directory %s -- %s\n", _fixtures.dir, STRERROR);
+        FREE(_fixtures.dir);
+}
+
+
+/**
+ * Generate the fixture files and the control file which checks them
+ */
+static boolean_t _fixturesCreate(StringBuffer_T config) {
+        char path[PATH_MAX];
+        const char *dir = _fixtures.dir;
+        StringBuffer_append(config,
+                            "set log %s/monit.log\n"
+                            "set idfile %s/monit.id\n"
+                            "set statefile %s/monit.state\n\n",
+                            dir, dir, dir);
+        // The process check watches Monit itself
+        snprintf(path, sizeof(path), "%s/monit.pid", dir);
+        char pid[12];
+        snprintf(pid, sizeof(pid), "%d\n", getpid());
+        if (! _write(path, pid))
+                return false;
+        StringBuffer_append(config,
+                            "check process monit with pidfile %s\n"
+                            "        if cpu > 90%% then alert\n"
+                            "        if totalmem > 1 GB then alert\n\n"
+                            "check directory fixtures with path %s\n"
+                            "        if changed timestamp then alert\n\n",
+                            path, dir);
+        for (int i = 0; i < FIXTURE_FILES; i++) {
+                snprintf(path, sizeof(path), "%s/file%d", dir, i);
+                if (! _write(path, "fixture\n"))
+                        return false;
+                StringBuffer_append(config,
+                                    "check file file%d with path %s\n"
+                                    "        if failed permission 600 then alert\n"
+                                    "        if size > 1 MB then alert\n"
+                                    "        if changed timestamp then alert\n\n",
+                                    i, path);
+        }
+        for (int i = 0; i < FIXTURE_FILES; i++) {
+                snprintf(path, sizeof(path), "%s/checksum%d", dir, i);
+                StringBuffer_T content = StringBuffer_create(8192);
+                for (int j = 0; j < 256; j++)
+                        StringBuffer_append(content, "%d: checksum fixture line %d\n", i, j);
+                boolean_t rv = _write(path, StringBuffer_toString(content));
+                StringBuffer_free(&content);
+                if (! rv)
+                        return false;
+                StringBuffer_append(config,
+                                    "check file checksum%d with path %s\n"
+                                    "        if changed sha1 checksum then alert\n\n",
+                                    i, path);
+        }
+        for (int i = 0; i < FIXTURE_FILES; i++) {
+                snprintf(path, sizeof(path), "%s/content%d.log", dir, i);
+                StringBuffer_T content = StringBuffer_create(8192);
+                for (int j = 0; j < 256; j++)
+                        StringBuffer_append(content, "%s request %d served\n", j % 64 ? "INFO" : "ERROR", j);
+                boolean_t rv = _write(path, StringBuffer_toString(content));
+                StringBuffer_free(&content);
+                if (! rv)
+                        return false;
+                StringBuffer_append(config,
+                                    "check file content%d with path %s\n"
+                                    "        ignore content = \"^INFO\"\n"
+                                    "        if content = \"^ERROR\" then alert\n\n",
+                                    i, path);
+        }
+        _fixtures.running = true;
+        for (int i = 0; i < FIXTURE_SERVERS; i++) {
+                if (! _serverStart(&_fixtures.server[i]))
+                        return false;
+                _fixtures.servers++;
+                StringBuffer_append(config,
+                                    "check host server%d with address 127.0.0.1\n"
+                                    "        if failed port %d then alert\n"
+                                    "        if failed port %d send \"PING\\r\\n\" expect \"PONG\" then alert\n\n",
+                                    i, _fixtures.server[i].port, _fixtures.server[i].port);
+        }
+        snprintf(path, sizeof(path), "%s/monitrc", dir);
+        if (! _write(path, StringBuffer_toString(config)))
+                return false;
+        Run.files.control = Str_dup(path);
+        return true;
+}
+
+
+/**
+ * Start counting the hardware cache misses of this process in user space. The counter is optional: it is
+ * not available if the kernel or the virtualization layer does not expose it, or perf_event_paranoid denies it
+ */
+static void _cacheMissesOpen() {
+#if defined HAVE_LINUX_PERF_EVENT_H && defined SYS_perf_event_open
+        struct perf_event_attr attr = {
+                .type = PERF_TYPE_HARDWARE,
+                .size = sizeof(attr),
+                .config = PERF_COUNT_HW_CACHE_MISSES,
+                .exclude_kernel = 1,
+                .exclude_hv = 1
+        };
+        _cachemisses = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (_cachemisses < 0)
+                DEBUG("Benchmark: cache misses counter is not available -- %s\n", STRERROR);
+#endif
+}
+
+
+static void _cacheMissesClose() {
+#if defined HAVE_LINUX_PERF_EVENT_H && defined SYS_perf_event_open
+        if (_cachemisses >= 0) {
+                close(_cachemisses);
+                _cachemisses = -1;
+        }
+#endif
+}
+
+
+static void _usage(Usage_T *u) {
+        memset(u, 0, sizeof(*u));
+        u->syscr = u->syscw = u->cachemisses = -1;
+        Mem_statistics(&u->allocations, &u->frees);
+#ifdef HAVE_SYS_RESOURCE_H
+        struct rusage r;
+        if (getrusage(RUSAGE_SELF, &r) == 0) {
+                u->user = (long long)r.ru_utime.tv_sec * 1000000LL + r.ru_utime.tv_usec;
+                u->system = (long long)r.ru_stime.tv_sec * 1000000LL + r.ru_stime.tv_usec;
+                u->voluntary = r.ru_nvcsw;
+                u->involuntary = r.ru_nivcsw;
+        }
+#endif
+#ifdef LINUX
+        FILE *f = fopen("/proc/self/io", "r");
+        if (f) {
+                char line[STRLEN];
+                while (fgets(line, sizeof(line), f)) {
+                        if (sscanf(line, "syscr: %lld", &u->syscr) != 1)
+                                sscanf(line, "syscw: %lld", &u->syscw);
+                }
+                fclose(f);
+        }
+#endif
+#if defined HAVE_LINUX_PERF_EVENT_H && defined SYS_perf_event_open
+        unsigned long long misses;
+        if (_cachemisses >= 0 && read(_cachemisses, &misses, sizeof(misses)) == sizeof(misses))
+                u->cachemisses = (long long)misses;
+#endif
+        u->time = Time_monotonicMicro();
+}
+
+
+static void _reset() {
+        Timing_T parse = Run.timing.parse;
+        memset(&Run.timing, 0, sizeof(Run.timing));
+        Run.timing.parse = parse;
+        for (Service_T s = servicelist; s; s = s->next)
+                memset(&s->timing, 0, sizeof(s->timing));
+}
+
+
+static void _printTiming(const char *name, const char *services, Timing_T *t) {
+        printf("%-20s %8s %10llu %12s", name, services, t->count, Str_milliToTime(t->total / 1000., (char[23]){}));
+        printf(" %12s", Str_milliToTime(t->count ? t->total / t->count / 1000. : 0., (char[23]){}));
+        printf(" %12s\n", Str_milliToTime(t->max / 1000., (char[23]){}));
+}
+
+
+/* ------------------------------------------------------------------ Public */
+
+
+boolean_t Bench_fixtures() {
+        char dir[PATH_MAX];
+        const char *tmp = getenv("TMPDIR");
+        snprintf(dir, sizeof(dir), "%s/monit-bench.XXXXXX", tmp && *tmp ? tmp : "/tmp");
+        if (! mkdtemp(dir)) {
+                LogError("Benchmark: cannot create the fixture directory %s -- %s\n", dir, STRERROR);
+                return false;
+        }
+        _fixtures.dir = Str_dup(dir);
+        _fixtures.pid = getpid();
+        atexit(_fixturesRemove);
+        StringBuffer_T config = StringBuffer_create(16384);
+        boolean_t rv = _fixturesCreate(config);
+        StringBuffer_free(&config);
+        return rv;
+}
+
+
+boolean_t Bench_run(int cycles) {
+        if (cycles < 1) {
+                LogError("Invalid number of benchmark cycles -- %d\n", cycles);
+                return false;
+        }
+        int services = 0;
+        long long configuration = 0LL;
+        for (Service_T s = servicelist; s; s = s->next) {
+                services++;
+                configuration += Arena_size(s->arena);
+        }
+        Run.flags |= Run_Bench;
+        // The first cycle initializes the services and the process and system data, exclude it from the measurement
+        validate();
+        _reset();
+        _cacheMissesOpen();
+        Usage_T start, stop;
+        _usage(&start);
+        int cycle;
+        for (cycle = 0; cycle < cycles && ! (Run.flags & Run_Stopped); cycle++)
+                validate();
+        _usage(&stop);
+        _cacheMissesClose();
+        Run.flags &= ~Run_Bench;
+        if (cycle == 0)
+                return false;
+        double duration = (stop.time - start.time) / 1000.;
+        if (_fixtures.dir)
+                printf("Benchmark of %d cycles, %d services, built-in fixtures in '%s'\n\n", cycle, services, _fixtures.dir);
+        else
+                printf("Benchmark of %d cycles, %d services, control file '%s'\n\n", cycle, services, Run.files.control);
+        printf(" %-20s = %.1f\n", "Cycles per second", duration > 0. ? cycle * 1000. / duration : 0.);
+        printf(" %-20s = %s\n", "Total time", Str_milliToTime(duration, (char[23]){}));
+        printf(" %-20s = %s\n", "Average cycle", Str_milliToTime(duration / cycle, (char[23]){}));
+        printf(" %-20s = %s user, %s system\n", "CPU time", Str_milliToTime((stop.user - start.user) / 1000., (char[23]){}), Str_milliToTime((stop.system - start.system) / 1000., (char[23]){}));
+        printf(" %-20s = %lld voluntary, %lld involuntary\n", "Context switches", stop.voluntary - start.voluntary, stop.involuntary - start.involuntary);
+        printf(" %-20s = %llu (%.1f per cycle)\n", "Allocations", stop.allocations - start.allocations, (double)(stop.allocations - start.allocations) / cycle);
+        printf(" %-20s = %llu (%.1f per cycle)\n", "Deallocations", stop.frees - start.frees, (double)(stop.frees - start.frees) / cycle);
+        if (start.syscr >= 0 && stop.syscr >= 0)
+                printf(" %-20s = %lld read, %lld write (%.1f per cycle)\n", "System calls", stop.syscr - start.syscr, stop.syscw - start.syscw, (double)(stop.syscr - start.syscr + stop.syscw - start.syscw) / cycle);
+        if (start.cachemisses >= 0 && stop.cachemisses >= 0)
+                printf(" %-20s = %lld (%.1f per cycle, %.1f per service)\n", "Cache misses", stop.cachemisses - start.cachemisses, (double)(stop.cachemisses - start.cachemisses) / cycle, services ? (double)(stop.cachemisses - start.cachemisses) / cycle / services : 0.);
+        printf(" %-20s = %s (%s per service)\n", "Service memory", Str_bytesToSize(configuration, (char[10]){}), Str_bytesToSize(services ? configuration / services : 0, (char[10]){}));
+        int atoms;
+        long atomsize;
+        Atom_statistics(&atoms, &atomsize);
+        printf(" %-20s = %d (%s)\n", "Interned strings", atoms, Str_bytesToSize(atomsize, (char[10]){}));
+        printf("\n%-20s %8s %10s %12s %12s %12s\n", "Stage", "", "Count", "Total", "Average", "Max");
+        _printTiming("control file parse", "", &Run.timing.parse);
+        _printTiming("cycle", "", &Run.timing.cycle);
+        _printTiming("system info update", "", &Run.timing.system);
+        _printTiming("process tree update", "", &Run.timing.processes);
+        printf("\n%-20s %8s %10s %12s %12s %12s\n", "Service type", "Services", "Checks", "Total", "Average", "Max");
+        for (int type = 0; type <= Service_Last; type++) {
+                int count = 0;
+                Timing_T t = {};
+                for (Service_T s = servicelist; s; s = s->next) {
+                        if (s->type == type) {
+                                count++;
+                                t.count += s->timing.count;
+                                t.total += s->timing.total;
+                                if (s->timing.max > t.max)
+                                        t.max = s->timing.max;
+                        }
+                }
+                if (count) {
+                        char services[11];
+                        snprintf(services, sizeof(services), "%d", count);
+                        _printTiming(servicetypes[type], services, &t);
+                }
+        }
+        return true;
+}
+
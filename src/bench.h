@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+#ifndef MONIT_BENCH_H
+#define MONIT_BENCH_H
+
+
+/**
+ * Benchmark of Monit's own throughput.
+ *
+ * Runs the given number of validation cycles back-to-back and reports the
+ * cycles per second, the duration of the validation stages and of the
+ * checks per service type, the memory allocations and the CPU and system
+ * call usage. The alerts, actions and the event queue are suppressed and
+ * the state file is not touched. Unless a control file is given explicitly,
+ * the benchmark generates its own fixtures: files, checksum and content
+ * match files in a temporary directory and mock TCP servers on ephemeral
+ * loopback ports, with a built-in control file which checks them, so the
+ * results are reproducible and the user's services are not touched.
+ *
+ *  @file
+ */
+
+
+/**
+ * Default number of the benchmark cycles
+ */
+#define BENCH_CYCLES 100
+
+
+/**
+ * Generate the benchmark fixtures and the built-in control file and set
+ * Run.files.control to it. Must be called before the control file is
+ * parsed. The mock servers are stopped and the fixture directory is
+ * removed when the program exits
+ * @return true if succeeded, otherwise false
+ */
+boolean_t Bench_fixtures();
+
+
+/**
+ * Run the benchmark and print the report to stdout
+ * @param cycles Number of validation cycles to run
+ * @return true if succeeded, otherwise false
+ */
+boolean_t Bench_run(int cycles);
+
+
+#endif
+
@@ -74,6 +74,7 @@
 
 // libmonit
 #include "io/File.h"
+#include "io/FileCache.h"
 #include "system/Time.h"
 #include "exceptions/AssertException.h"
 
@@ -202,15 +203,16 @@ static boolean_t _getNfsDiskActivity(void *_inf) {
 static boolean_t _getZfsDiskActivity(void *_inf) {
         Info_T inf = _inf;
         char path[PATH_MAX];
+        char buf[STRLEN * 2];
         snprintf(path, sizeof(path), "/proc/spl/kstat/zfs/%s/io", inf->filesystem->object.key);
-        FILE *f = fopen(path, "r");
-        if (f) {
-                char line[STRLEN];
+        if (FileCache_read(path, buf, sizeof(buf)) >= 0) {
                 uint64_t now = Time_milli();
                 uint64_t waitTime = 0ULL, runTime = 0ULL;
                 uint64_t readOperations = 0ULL, readBytes = 0ULL;
                 uint64_t writeOperations = 0ULL, writeBytes = 0ULL;
-                while (fgets(line, sizeof(line), f)) {
+                for (char *line = buf; line; line = strchr(line, '\n')) {
+                        if (*line == '\n')
+                                line++;
                         if (sscanf(line, "%"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64" %*u %*u %"PRIu64"", &readBytes, &writeBytes, &readOperations, &writeOperations, &waitTime, &runTime) == 6) {
                                 Statistics_update(&(inf->filesystem->read.bytes), now, readBytes);
                                 Statistics_update(&(inf->filesystem->read.operations), now, readOperations);
@@ -221,7 +223,6 @@ static boolean_t _getZfsDiskActivity(void *_inf) {
                                 break;
                         }
                 }
-                fclose(f);
                 return true;
         }
         LogError("filesystem statistic error: cannot read %s -- %s\n", path, STRERROR);
@@ -232,14 +233,13 @@ static boolean_t _getZfsDiskActivity(void *_inf) {
 static boolean_t _getSysfsBlockDiskActivity(void *_inf) {
         Info_T inf = _inf;
         char path[PATH_MAX];
+        char buf[STRLEN];
         snprintf(path, sizeof(path), "/sys/class/block/%s/stat", inf->filesystem->object.key);
-        FILE *f = fopen(path, "r");
-        if (f) {
+        if (FileCache_read(path, buf, sizeof(buf)) >= 0) {
                 uint64_t now = Time_milli();
                 uint64_t readOperations = 0ULL, readSectors = 0ULL, readTime = 0ULL;
                 uint64_t writeOperations = 0ULL, writeSectors = 0ULL, writeTime = 0ULL;
-                if (fscanf(f, "%"PRIu64" %*u %"PRIu64" %"PRIu64" %"PRIu64" %*u %"PRIu64" %"PRIu64" %*u %*u %*u", &readOperations, &readSectors, &readTime, &writeOperations, &writeSectors, &writeTime) != 6) {
-                        fclose(f);
+                if (sscanf(buf, "%"PRIu64" %*u %"PRIu64" %"PRIu64" %"PRIu64" %*u %"PRIu64" %"PRIu64" %*u %*u %*u", &readOperations, &readSectors, &readTime, &writeOperations, &writeSectors, &writeTime) != 6) {
                         LogError("filesystem statistic error: cannot parse %s -- %s\n", path, STRERROR);
                         return false;
                 }
@@ -249,7 +249,6 @@ static boolean_t _getSysfsBlockDiskActivity(void *_inf) {
                 Statistics_update(&(inf->filesystem->time.write), now, writeTime);
                 Statistics_update(&(inf->filesystem->write.bytes), now, writeSectors * 512);
                 Statistics_update(&(inf->filesystem->write.operations), now, writeOperations);
-                fclose(f);
                 return true;
         }
         LogError("filesystem statistic error: cannot read %s -- %s\n", path, STRERROR);
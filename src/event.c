@@ -62,6 +62,7 @@
 #include "event.h"
 #include "ProcessTree.h"
 #include "MMonit.h"
+#include "eventstream.h"
 
 // libmonit
 #include "io/File.h"
@@ -113,6 +114,10 @@ EventTable_T Event_Table[] = {
 };
 
 
+/* Serializes the alert and M/Monit delivery of Event_post() and Event_notify() */
+static Mutex_T _deliveryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
 /* ----------------------------------------------------------------- Private */
 
 
@@ -284,10 +289,18 @@ static void _handleAction(Event_T E, Action_T A) {
 
         E->flag = Handler_Succeeded;
 
+        /* The benchmark mode measures the checks only, the alerts and actions are suppressed */
+        if (Run.flags & Run_Bench)
+                return;
+
         if (A->id != Action_Ignored) {
                 /* Alert and mmonit event notification are common actions */
-                E->flag |= MMonit_send(E);
-                E->flag |= handle_alert(E);
+                LOCK(_deliveryMutex)
+                {
+                        E->flag |= MMonit_send(E);
+                        E->flag |= handle_alert(E);
+                }
+                END_LOCK;
                 /* In the case that some subhandler failed, enqueue the event for partial reprocessing */
                 if (E->flag != Handler_Succeeded) {
                         if (Run.eventlist_dir)
@@ -301,6 +314,7 @@ static void _handleAction(Event_T E, Action_T A) {
                 } else if (A->id == Action_Exec) {
                         if (E->state_changed || (E->state && A->repeat && E->count % A->repeat == 0)) {
                                 LogInfo("'%s' exec: '%s'\n", E->source->name, Util_commandDescription(A->exec, (char[STRLEN]){}));
+                                EventStream_postAction(E->source, E, A->id);
                                 spawn(E->source, A->exec, E);
                                 return;
                         }
@@ -309,6 +323,7 @@ static void _handleAction(Event_T E, Action_T A) {
                                 E->source->nstart++;
                         if (E->source->mode == Monitor_Passive && (A->id == Action_Start || A->id == Action_Stop  || A->id == Action_Restart))
                                 return;
+                        EventStream_postAction(E->source, E, A->id);
                         control_service(E->source->name, A->id);
                 }
         }
@@ -332,24 +347,26 @@ static void _handleEvent(Service_T S, Event_T E) {
         if (E->message) {
                 if (E->id == Event_Instance || E->id == Event_Action) {
                         // Instance and action events are logged always with priority info
-                        LogInfo("'%s' %s\n", S->name, E->message);
+                        LogEvent(LOG_INFO, S, E);
                 } else if (E->state == State_Succeeded || E->state == State_ChangedNot) {
                         if (E->state_map & 0x1) {
                                 // Failure, but didn't reach the error threshold yet
-                                LogWarning("'%s' %s\n", S->name, E->message);
+                                LogEvent(LOG_WARNING, S, E);
                         } else {
                                 // Success
-                                LogInfo("'%s' %s\n", S->name, E->message);
+                                LogEvent(LOG_INFO, S, E);
                         }
                 } else if (E->state == State_Init) {
                         if (E->state_map & 0x1) {
                                 // Log error which occur while the service is initializing as warnings, success is not logged in the initializing state
-                                LogWarning("'%s' %s\n", S->name, E->message);
+                                LogEvent(LOG_WARNING, S, E);
+                                EventStream_postState(S, E);
                         }
                         return;
                 } else {
-                        LogError("'%s' %s\n", S->name, E->message);
+                        LogEvent(LOG_ERR, S, E);
                 }
+                EventStream_postState(S, E);
         }
 
         if (E->state == State_Failed || E->state == State_Changed) {
@@ -450,6 +467,46 @@ void Event_post(Service_T service, long id, State_Type state, EventAction_T acti
  * @return A string describing the event type in clear text. If the
  * event type is not found NULL is returned.
  */
+void Event_notify(Service_T service, long id, State_Type state, EventAction_T action, char *s, ...) {
+        ASSERT(service);
+        ASSERT(action);
+        ASSERT(s);
+        ASSERT(state == State_Failed || state == State_Succeeded);
+
+        va_list ap;
+        va_start(ap, s);
+        struct myevent e = {
+                .id = id,
+                .source = service,
+                .mode = service->mode,
+                .type = service->type,
+                .state = state,
+                .state_changed = true,
+                .flag = Handler_Succeeded,
+                .state_map = state == State_Failed ? 1 : 0,
+                .count = 1,
+                .message = Str_vcat(s, ap),
+                .action = action
+        };
+        va_end(ap);
+        gettimeofday(&e.collected, NULL);
+        LogEvent(state == State_Failed ? LOG_ERR : LOG_INFO, service, &e);
+        EventStream_postState(service, &e);
+        Action_T a = state == State_Failed ? action->failed : action->succeeded;
+        if (a->id != Action_Ignored && ! (Run.flags & Run_Bench)) {
+                LOCK(_deliveryMutex)
+                {
+                        e.flag |= MMonit_send(&e);
+                        e.flag |= handle_alert(&e);
+                }
+                END_LOCK;
+                if (e.flag != Handler_Succeeded)
+                        LogError("'%s' notification about '%s' was not delivered\n", service->name, e.message);
+        }
+        FREE(e.message);
+}
+
+
 const char *Event_get_description(Event_T E) {
         ASSERT(E);
         EventTable_T *et = Event_Table;
@@ -526,7 +583,7 @@ const char *Event_get_action_description(Event_T E) {
  */
 void Event_queue_process() {
         /* return in the case that the eventqueue is not enabled or empty */
-        if (! Run.eventlist_dir || (! (Run.flags & Run_HandlerInit) && ! Run.handler_queue[Handler_Alert] && ! Run.handler_queue[Handler_Mmonit]))
+        if (! Run.eventlist_dir || (Run.flags & Run_Bench) || (! (Run.flags & Run_HandlerInit) && ! Run.handler_queue[Handler_Alert] && ! Run.handler_queue[Handler_Mmonit]))
                 return;
 
         DIR *dir = opendir(Run.eventlist_dir);
@@ -103,6 +103,23 @@ extern EventTable_T Event_Table[];
 void Event_post(Service_T service, long id, State_Type state, EventAction_T action, char *s, ...) __attribute__((format (printf, 5, 6)));
 
 
+/**
+ * Notify about an event without recording it in the service's event
+ * list: the event is logged, published to the event stream and sent to
+ * the alert recipients and M/Monit, but the action is not executed and
+ * the event is not queued if the delivery fails. The delivery is
+ * serialized with Event_post(), so this method can be called from a
+ * thread other than the validation thread, such as the watchdog when
+ * the validation thread is blocked
+ * @param service The Service the event belongs to
+ * @param id The event identification
+ * @param state The event state, State_Failed or State_Succeeded
+ * @param action Description of the event action
+ * @param s Optional message describing the event
+ */
+void Event_notify(Service_T service, long id, State_Type state, EventAction_T action, char *s, ...) __attribute__((format (printf, 5, 6)));
+
+
 /**
  * Get a textual description of actual event type. For instance if the
  * event type is possitive Event_Timestamp, the textual description is
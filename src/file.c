@@ -69,6 +69,7 @@
 
 // libmonit
 #include "io/File.h"
+#include "io/FileCache.h"
 
 /**
  *  Utilities for managing files used by monit.
@@ -281,10 +282,19 @@ boolean_t file_readProc(char *buf, int buf_size, char *name, int pid, int *bytes
         ASSERT(name);
 
         char filename[STRLEN];
-        if (pid < 0)
+        if (pid < 0) {
+                // System-wide files are read each cycle => keep the descriptor open and re-read it
                 snprintf(filename, sizeof(filename), "/proc/%s", name);
-        else
-                snprintf(filename, sizeof(filename), "/proc/%d/%s", pid, name);
+                int bytes = (int)FileCache_read(filename, buf, buf_size);
+                if (bytes < 0) {
+                        DEBUG("Cannot read proc file '%s' -- %s\n", filename, STRERROR);
+                        return false;
+                }
+                if (bytes_read)
+                        *bytes_read = bytes;
+                return true;
+        }
+        snprintf(filename, sizeof(filename), "/proc/%d/%s", pid, name);
 
         int fd = open(filename, O_RDONLY);
         if (fd < 0) {
@@ -47,30 +47,9 @@ static void _gc_service(Service_T *);
 static void _gc_servicegroup(ServiceGroup_T *);
 static void _gc_mail_server(MailServer_T *);
 static void _gcportlist(Port_T *);
-static void _gcfilesystem(FileSystem_T *);
 static void _gcicmp(Icmp_T *);
-static void _gcpql(Resource_T *);
-static void _gcptl(Timestamp_T *);
-static void _gcparl(ActionRate_T *);
-static void _gc_action(Action_T *);
-static void _gc_eventaction(EventAction_T *);
 static void _gcpdl(Dependant_T *);
-static void _gcso(Size_T *);
-static void _gclinkstatus(LinkStatus_T *);
-static void _gclinkspeed(LinkSpeed_T *);
-static void _gclinksaturation(LinkSaturation_T *);
-static void _gcbandwidth(Bandwidth_T *);
 static void _gcmatch(Match_T *);
-static void _gcchecksum(Checksum_T *);
-static void _gcperm(Perm_T *);
-static void _gcstatus(Status_T *);
-static void _gcuid(Uid_T *);
-static void _gcgid(Gid_T *);
-static void _gcpid(Pid_T *);
-static void _gcppid(Pid_T *);
-static void _gcfsflag(FsFlag_T *);
-static void _gcnonexist(NonExist_T *);
-static void _gcexist(Exist_T *);
 static void _gcgeneric(Generic_T *);
 static void _gcath(Auth_T *);
 static void _gc_mmonit(Mmonit_T *);
@@ -90,13 +69,23 @@ static void _gcssloptions(SslOptions_T o);
 
 
 void gc() {
-        Engine_destroyAllow();
         if (Run.flags & Run_ProcessEngineEnabled)
                 ProcessTree_delete();
+        if (servicetable)
+                Table_free(&servicetable);
+        if (servicegrouptable)
+                Table_free(&servicegrouptable);
         if (servicelist)
                 _gc_service_list(&servicelist);
         if (servicegrouplist)
                 _gc_servicegroup(&servicegrouplist);
+        gc_config();
+        // The atoms were released with the rules above, the atom table is freed with the last one
+}
+
+
+void gc_config() {
+        Engine_destroyAllow();
         if (Run.httpd.credentials)
                 _gcath(&Run.httpd.credentials);
         if (Run.maillist)
@@ -106,6 +95,7 @@ void gc() {
         if (Run.mmonits)
                 _gc_mmonit(&Run.mmonits);
         FREE(Run.eventlist_dir);
+        FREE(Run.syslog.host);
         FREE(Run.mygroup);
         if (Run.httpd.flags & Httpd_Net) {
                 FREE(Run.httpd.socket.net.address);
@@ -123,6 +113,16 @@ void gc() {
 }
 
 
+void gc_service(Service_T *s) {
+        _gc_service(s);
+}
+
+
+void gc_servicegroup(ServiceGroup_T *sg) {
+        _gc_servicegroup(sg);
+}
+
+
 void gc_mail_list(Mail_T *m) {
         ASSERT(m);
         if ((*m)->next)
@@ -131,7 +131,7 @@ void gc_mail_list(Mail_T *m) {
                 Address_free(&((*m)->from));
         if ((*m)->replyto)
                 Address_free(&((*m)->replyto));
-        FREE((*m)->to);
+        Atom_free(&((*m)->to));
         FREE((*m)->subject);
         FREE((*m)->message);
         FREE(*m);
@@ -187,115 +187,37 @@ static void _gc_service(Service_T *s) {
                 if ((*s)->program->args)
                         gccmd(&(*s)->program->args);
                 StringBuffer_free(&((*s)->program->output));
-                FREE((*s)->program);
         }
         if ((*s)->portlist)
                 _gcportlist(&(*s)->portlist);
         if ((*s)->socketlist)
                 _gcportlist(&(*s)->socketlist);
-        if ((*s)->filesystemlist)
-                _gcfilesystem(&(*s)->filesystemlist);
         if ((*s)->icmplist)
                 _gcicmp(&(*s)->icmplist);
         if ((*s)->maillist)
                 gc_mail_list(&(*s)->maillist);
-        if ((*s)->resourcelist)
-                _gcpql(&(*s)->resourcelist);
-        if ((*s)->timestamplist)
-                _gcptl(&(*s)->timestamplist);
-        if ((*s)->actionratelist)
-                _gcparl(&(*s)->actionratelist);
-        if ((*s)->sizelist)
-                _gcso(&(*s)->sizelist);
-        if ((*s)->linkstatuslist)
-                _gclinkstatus(&(*s)->linkstatuslist);
-        if ((*s)->linkspeedlist)
-                _gclinkspeed(&(*s)->linkspeedlist);
-        if ((*s)->linksaturationlist)
-                _gclinksaturation(&(*s)->linksaturationlist);
-        if ((*s)->uploadbyteslist)
-                _gcbandwidth(&(*s)->uploadbyteslist);
-        if ((*s)->uploadpacketslist)
-                _gcbandwidth(&(*s)->uploadpacketslist);
-        if ((*s)->downloadbyteslist)
-                _gcbandwidth(&(*s)->downloadbyteslist);
-        if ((*s)->downloadpacketslist)
-                _gcbandwidth(&(*s)->downloadpacketslist);
         if ((*s)->matchlist)
                 _gcmatch(&(*s)->matchlist);
         if ((*s)->matchignorelist)
                 _gcmatch(&(*s)->matchignorelist);
-        if ((*s)->checksum)
-                _gcchecksum(&(*s)->checksum);
-        if ((*s)->perm)
-                _gcperm(&(*s)->perm);
-        if ((*s)->statuslist)
-                _gcstatus(&(*s)->statuslist);
         if ((*s)->every.type == Every_Cron || (*s)->every.type == Every_NotInCron)
                 FREE((*s)->every.spec.cron);
-        if ((*s)->uid)
-                _gcuid(&(*s)->uid);
-        if ((*s)->euid)
-                _gcuid(&(*s)->euid);
-        if ((*s)->gid)
-                _gcgid(&(*s)->gid);
-        if ((*s)->pidlist)
-                _gcpid(&(*s)->pidlist);
-        if ((*s)->ppidlist)
-                _gcppid(&(*s)->ppidlist);
-        if ((*s)->fsflaglist)
-                _gcfsflag(&(*s)->fsflaglist);
-        if ((*s)->nonexistlist)
-                _gcnonexist(&(*s)->nonexistlist);
-        if ((*s)->existlist)
-                _gcexist(&(*s)->existlist);
         if ((*s)->dependantlist)
                 _gcpdl(&(*s)->dependantlist);
         if ((*s)->start)
                 gccmd(&(*s)->start);
         if ((*s)->stop)
                 gccmd(&(*s)->stop);
-        if ((*s)->action_DATA)
-                _gc_eventaction(&(*s)->action_DATA);
-        if ((*s)->action_EXEC)
-                _gc_eventaction(&(*s)->action_EXEC);
-        if ((*s)->action_INVALID)
-                _gc_eventaction(&(*s)->action_INVALID);
-        if ((*s)->action_MONIT_START)
-                _gc_eventaction(&(*s)->action_MONIT_START);
-        if ((*s)->action_MONIT_STOP)
-                _gc_eventaction(&(*s)->action_MONIT_STOP);
-        if ((*s)->action_ACTION)
-                _gc_eventaction(&(*s)->action_ACTION);
         if ((*s)->eventlist)
                 gc_event(&(*s)->eventlist);
-        switch ((*s)->type) {
-                case Service_Directory:
-                        FREE((*s)->inf.directory);
-                        break;
-                case Service_Fifo:
-                        FREE((*s)->inf.fifo);
-                        break;
-                case Service_File:
-                        FREE((*s)->inf.file);
-                        break;
-                case Service_Filesystem:
-                        FREE((*s)->inf.filesystem);
-                        break;
-                case Service_Net:
-                        Link_free(&((*s)->inf.net->stats));
-                        FREE((*s)->inf.net);
-                        break;
-                case Service_Process:
-                        FREE((*s)->inf.process);
-                        break;
-                default:
-                        break;
-        }
+        if ((*s)->type == Service_Net)
+                Link_free(&((*s)->inf.net->stats));
         FREE((*s)->name);
         FREE((*s)->path);
-        (*s)->next = NULL;
-        FREE(*s);
+        // The service, its rules and event actions are allocated from the service arena
+        Arena_T arena = (*s)->arena;
+        *s = NULL;
+        Arena_free(&arena);
 }
 
 
@@ -304,7 +226,7 @@ static void _gc_servicegroup(ServiceGroup_T *sg) {
         if ((*sg)->next)
                 _gc_servicegroup(&(*sg)->next);
         List_free(&(*sg)->members);
-        FREE((*sg)->name);
+        Atom_free(&(*sg)->name);
         FREE(*sg);
 }
 
@@ -346,35 +268,17 @@ static void _gc_mail_server(MailServer_T *s) {
 }
 
 
-static void _gc_action(Action_T *a) {
-        ASSERT(a&&*a);
-        if ((*a)->exec)
-                gccmd(&(*a)->exec);
-        FREE(*a);
-}
-
-
-static void _gc_eventaction(EventAction_T *e) {
-        ASSERT(e&&*e);
-        _gc_action(&(*e)->failed);
-        _gc_action(&(*e)->succeeded);
-        FREE(*e);
-}
-
-
 static void _gcportlist(Port_T *p) {
         ASSERT(p&&*p);
         if ((*p)->next)
                 _gcportlist(&(*p)->next);
-        if ((*p)->action)
-                _gc_eventaction(&(*p)->action);
         if ((*p)->url_request)
                 _gc_request(&(*p)->url_request);
         if ((*p)->family == Socket_Unix)
                 FREE((*p)->target.unix.pathname);
         else
                 _gcssloptions(&((*p)->target.net.ssl.options));
-        FREE((*p)->hostname);
+        Atom_free(&((*p)->hostname));
         FREE((*p)->outgoing.ip);
         if ((*p)->protocol->check == check_http) {
                 FREE((*p)->parameters.http.username);
@@ -411,17 +315,6 @@ static void _gcportlist(Port_T *p) {
                 FREE((*p)->parameters.apachestatus.username);
                 FREE((*p)->parameters.apachestatus.password);
         }
-        FREE(*p);
-}
-
-
-static void _gcfilesystem(FileSystem_T *d) {
-        ASSERT(d&&*d);
-        if ((*d)->next)
-                _gcfilesystem(&(*d)->next);
-        if ((*d)->action)
-                _gc_eventaction(&(*d)->action);
-        FREE(*d);
 }
 
 
@@ -430,195 +323,17 @@ static void _gcicmp(Icmp_T *i) {
         if ((*i)->next)
                 _gcicmp(&(*i)->next);
         FREE((*i)->outgoing.ip);
-        if ((*i)->action)
-                _gc_eventaction(&(*i)->action);
-        FREE(*i);
-}
-
-
-static void _gcpql(Resource_T *q) {
-        ASSERT(q);
-        if ((*q)->next)
-                _gcpql(&(*q)->next);
-        if ((*q)->action)
-                _gc_eventaction(&(*q)->action);
-        FREE(*q);
 }
 
 
-static void _gcptl(Timestamp_T *p) {
-        ASSERT(p);
-        if ((*p)->next)
-                _gcptl(&(*p)->next);
-        if ((*p)->action)
-                _gc_eventaction(&(*p)->action);
-        FREE(*p);
-}
-
-
-static void _gcparl(ActionRate_T *ar) {
-        ASSERT(ar);
-        if ((*ar)->next)
-                _gcparl(&(*ar)->next);
-        if ((*ar)->action)
-                _gc_eventaction(&(*ar)->action);
-        FREE(*ar);
-}
-
-
-static void _gcso(Size_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcso(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-static void _gclinkstatus(LinkStatus_T *l) {
-        ASSERT(l);
-        if ((*l)->next)
-                _gclinkstatus(&(*l)->next);
-        if ((*l)->action)
-                _gc_eventaction(&(*l)->action);
-        FREE(*l);
-}
-
-
-static void _gclinkspeed(LinkSpeed_T *l) {
-        ASSERT(l);
-        if ((*l)->next)
-                _gclinkspeed(&(*l)->next);
-        if ((*l)->action)
-                _gc_eventaction(&(*l)->action);
-        FREE(*l);
-}
-
-
-static void _gclinksaturation(LinkSaturation_T *l) {
-        ASSERT(l);
-        if ((*l)->next)
-                _gclinksaturation(&(*l)->next);
-        if ((*l)->action)
-                _gc_eventaction(&(*l)->action);
-        FREE(*l);
-}
-
-
-static void _gcbandwidth(Bandwidth_T *b) {
-        ASSERT(b);
-        if ((*b)->next)
-                _gcbandwidth(&(*b)->next);
-        if ((*b)->action)
-                _gc_eventaction(&(*b)->action);
-        FREE(*b);
-}
-
 static void _gcmatch(Match_T *s) {
         ASSERT(s);
         if ((*s)->next)
                 _gcmatch(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
         FREE((*s)->match_path);
-        FREE((*s)->match_string);
-        if ((*s)->regex_comp) {
+        Atom_free(&((*s)->match_string));
+        if ((*s)->regex_comp)
                 regfree((*s)->regex_comp);
-                FREE((*s)->regex_comp);
-        }
-        FREE(*s);
-}
-
-
-static void _gcchecksum(Checksum_T *s) {
-        ASSERT(s);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcperm(Perm_T *s) {
-        ASSERT(s);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcstatus(Status_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcstatus(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcuid(Uid_T *s) {
-        ASSERT(s);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcgid(Gid_T *s) {
-        ASSERT(s);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcpid(Pid_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcpid(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcppid(Pid_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcppid(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcfsflag(FsFlag_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcfsflag(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcnonexist(NonExist_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcnonexist(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
-}
-
-
-static void _gcexist(Exist_T *s) {
-        ASSERT(s);
-        if ((*s)->next)
-                _gcexist(&(*s)->next);
-        if ((*s)->action)
-                _gc_eventaction(&(*s)->action);
-        FREE(*s);
 }
 
 
@@ -627,7 +342,6 @@ static void _gcpdl(Dependant_T *d) {
         if ((*d)->next)
                 _gcpdl(&(*d)->next);
         FREE((*d)->dependant);
-        FREE(*d);
 }
 
 
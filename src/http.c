@@ -59,6 +59,7 @@
 #include "monit.h"
 #include "net.h"
 #include "engine.h"
+#include "eventstream.h"
 
 // libmonit
 #include "exceptions/AssertException.h"
@@ -114,6 +115,7 @@ void monit_http(Httpd_Action action) {
                         LogDebug("Shutting down Monit HTTP server\n");
                         Engine_stop();
                         Thread_join(thread);
+                        EventStream_stop();
                         LogDebug("Monit HTTP server stopped\n");
                         running = false;
                         break;
@@ -122,6 +124,7 @@ void monit_http(Httpd_Action action) {
                                 LogDebug("Starting Monit HTTP server at [%s]:%d\n", Run.httpd.socket.net.address ? Run.httpd.socket.net.address : "*", Run.httpd.socket.net.port);
                         else if (Run.httpd.flags & Httpd_Unix)
                                 LogDebug("Starting Monit HTTP server at %s\n", Run.httpd.socket.unix.path);
+                        EventStream_start();
                         Thread_create(thread, thread_wrapper, NULL);
                         LogDebug("Monit HTTP server started\n");
                         running = true;
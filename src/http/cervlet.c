@@ -60,6 +60,10 @@
 #include <sys/stat.h>
 #endif
 
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
 #ifdef HAVE_SYS_TIME_H
 #include <sys/time.h>
 #endif
@@ -75,6 +79,7 @@
 #include "monit.h"
 #include "cervlet.h"
 #include "engine.h"
+#include "eventstream.h"
 #include "processor.h"
 #include "base64.h"
 #include "event.h"
@@ -99,11 +104,18 @@
 #define STATUS2     "/_status2"
 #define SUMMARY     "/_summary"
 #define REPORT      "/_report"
+#define STATS       "/_stats"
 #define RUNTIME     "/_runtime"
 #define VIEWLOG     "/_viewlog"
+#define EVENTS      "/_events"
 #define DOACTION    "/_doaction"
 #define FAVICON     "/favicon.ico"
 
+#define LOGVIEW_LINES  1000                  /* Default number of the log lines shown */
+#define LOGVIEW_LIMIT  1048576        /* Maximum log bytes served by one request */
+#define LOGVIEW_BLOCK  4096                       /* Log file read block size */
+#define LOGVIEW_FOLLOW 2000           /* Follow mode poll interval [ms] */
+
 
 typedef enum {
         TXT = 0,
@@ -133,6 +145,7 @@ static void do_ping(HttpResponse);
 static void do_getid(HttpResponse);
 static void do_runtime(HttpRequest, HttpResponse);
 static void do_viewlog(HttpRequest, HttpResponse);
+static void do_events(HttpRequest, HttpResponse);
 static void handle_service(HttpRequest, HttpResponse);
 static void handle_service_action(HttpRequest, HttpResponse);
 static void handle_doaction(HttpRequest, HttpResponse);
@@ -173,6 +186,7 @@ static void print_service_rules_resource(HttpResponse, Service_T);
 static void print_status(HttpRequest, HttpResponse, int);
 static void print_summary(HttpRequest, HttpResponse);
 static void _printReport(HttpRequest req, HttpResponse res);
+static void _printStats(HttpRequest req, HttpResponse res);
 static void status_service_txt(Service_T, HttpResponse);
 static char *get_monitoring_status(Output_Type, Service_T s, char *, int);
 static char *get_service_status(Output_Type, Service_T, char *, int);
@@ -230,6 +244,27 @@ static char *_getUptime(time_t delta, char s[256]) {
 }
 
 
+static char *_timingToString(unsigned long long micro, char s[23]) {
+        return Str_milliToTime(micro / 1000., s);
+}
+
+
+static void _printTiming(Output_Type type, HttpResponse res, const char *name, Timing_T *t) {
+        char last[23], average[23], max[23];
+        _timingToString(t->last, last);
+        _timingToString(t->count ? t->total / t->count : 0, average);
+        _timingToString(t->max, max);
+        if (type == HTML) {
+                StringBuffer_append(res->outputbuffer, "<tr><td>%s duration</td><td>%s (average %s, max %s, %llu measurements)</td></tr>", name, last, average, max, t->count);
+        } else {
+                StringBuffer_append(res->outputbuffer, "%-24s %10llu %12s %12s %12s", name, t->count, last, average, max);
+                for (int i = 0; i < TIMING_BUCKETS; i++)
+                        StringBuffer_append(res->outputbuffer, " %7llu", t->histogram[i]);
+                StringBuffer_append(res->outputbuffer, "\n");
+        }
+}
+
+
 static void _formatStatus(const char *name, Event_Type errorType, Output_Type type, HttpResponse res, Service_T s, boolean_t validValue, const char *value, ...) {
         if (type == HTML) {
                 StringBuffer_append(res->outputbuffer, "<tr><td>%c%s</td>", toupper(name[0]), name + 1);
@@ -267,7 +302,7 @@ static void _formatStatus(const char *name, Event_Type errorType, Output_Type ty
                                         column = 0;
                                         continue;
                                 } else if (column <= 200) {
-                                        StringBuffer_append(res->outputbuffer, "%c", _value[i]);
+                                        StringBuffer_appendChar(res->outputbuffer, _value[i]);
                                         column++;
                                 }
                         }
@@ -304,12 +339,22 @@ static void _printStatus(Output_Type type, HttpResponse res, Service_T s) {
                                 _formatStatus("cpu", Event_Resource, type, res, s, true, "%.1f%%us %.1f%%sy"
 #ifdef HAVE_CPU_WAIT
                                         " %.1f%%wa"
+#endif
+#ifdef HAVE_CPU_STEAL
+                                        " %.1f%%st %.1f%%gu %.1f%%hi %.1f%%si"
 #endif
                                         , systeminfo.cpu.usage.user > 0. ? systeminfo.cpu.usage.user : 0., systeminfo.cpu.usage.system > 0. ? systeminfo.cpu.usage.system : 0.
 #ifdef HAVE_CPU_WAIT
                                         , systeminfo.cpu.usage.wait > 0. ? systeminfo.cpu.usage.wait : 0.
+#endif
+#ifdef HAVE_CPU_STEAL
+                                        , systeminfo.cpu.usage.steal > 0. ? systeminfo.cpu.usage.steal : 0.
+                                        , systeminfo.cpu.usage.guest > 0. ? systeminfo.cpu.usage.guest : 0.
+                                        , systeminfo.cpu.usage.irq > 0. ? systeminfo.cpu.usage.irq : 0.
+                                        , systeminfo.cpu.usage.softirq > 0. ? systeminfo.cpu.usage.softirq : 0.
 #endif
                                 );
+                                _formatStatus("cpu cores", Event_Resource, type, res, s, systeminfo.cpu.core.count > 0, "%d [max %.1f%%]", systeminfo.cpu.core.count, systeminfo.cpu.core.max);
                                 _formatStatus("memory usage", Event_Resource, type, res, s, true, "%s [%.1f%%]", Str_bytesToSize(systeminfo.memory.usage.bytes, (char[10]){}), systeminfo.memory.usage.percent);
                                 _formatStatus("swap usage", Event_Resource, type, res, s, true, "%s [%.1f%%]", Str_bytesToSize(systeminfo.swap.usage.bytes, (char[10]){}), systeminfo.swap.usage.percent);
                                 _formatStatus("uptime", Event_Uptime, type, res, s, systeminfo.booted > 0, "%s", _getUptime(Time_now() - systeminfo.booted, (char[256]){}));
@@ -464,6 +509,7 @@ static void _printStatus(Output_Type type, HttpResponse res, Service_T s) {
                         }
                 }
         }
+        _formatStatus("check duration", Event_Null, type, res, s, s->timing.count > 0, "%s (average %s, max %s)", _timingToString(s->timing.last, (char[23]){}), _timingToString(s->timing.count ? s->timing.total / s->timing.count : 0, (char[23]){}), _timingToString(s->timing.max, (char[23]){}));
         _formatStatus("data collected", Event_Null, type, res, s, true, "%s", Time_string(s->collected.tv_sec, (char[32]){}));
 }
 
@@ -486,6 +532,8 @@ static void doPost(HttpRequest req, HttpResponse res) {
                 print_summary(req, res);
         else if (ACTION(REPORT))
                 _printReport(req, res);
+        else if (ACTION(STATS))
+                _printStats(req, res);
         else if (ACTION(DOACTION))
                 handle_doaction(req, res);
         else
@@ -500,6 +548,7 @@ static void doPost(HttpRequest req, HttpResponse res) {
 static void doGet(HttpRequest req, HttpResponse res) {
         set_content_type(res, "text/html");
         if (ACTION(HOME)) {
+                set_streaming(req, res);
                 LOCK(Run.mutex)
                 do_home(res);
                 END_LOCK;
@@ -521,8 +570,14 @@ static void doGet(HttpRequest req, HttpResponse res) {
                 print_status(req, res, 2);
         } else if (ACTION(SUMMARY)) {
                 print_summary(req, res);
+        } else if (ACTION(VIEWLOG)) {
+                do_viewlog(req, res);
+        } else if (ACTION(EVENTS)) {
+                do_events(req, res);
         } else if (ACTION(REPORT)) {
                 _printReport(req, res);
+        } else if (ACTION(STATS)) {
+                _printStats(req, res);
         } else {
                 handle_service(req, res);
         }
@@ -820,8 +875,24 @@ static void do_runtime(HttpRequest req, HttpResponse res) {
         StringBuffer_append(res->outputbuffer,
                             "<tr><td>On reboot</td><td>%s</td></tr>", onrebootnames[Run.onreboot]);
         StringBuffer_append(res->outputbuffer,
-                            "<tr><td>Poll time</td><td>%d seconds with start delay %d seconds</td></tr>",
-                            Run.polltime, Run.startdelay);
+                            "<tr><td>Poll time</td><td>%d seconds with start delay %d seconds%s</td></tr>",
+                            Run.polltime, Run.startdelay, Run.flags & Run_SpreadChecks ? ", checks spread over the interval" : "");
+        _printTiming(HTML, res, "Cycle", &Run.timing.cycle);
+        _printTiming(HTML, res, "Event queue", &Run.timing.events);
+        _printTiming(HTML, res, "System info update", &Run.timing.system);
+        _printTiming(HTML, res, "Process tree update", &Run.timing.processes);
+        _printTiming(HTML, res, "State save", &Run.timing.state);
+        _printTiming(HTML, res, "Control file parse", &Run.timing.parse);
+        StringBuffer_append(res->outputbuffer, "<tr><td>Cycle overruns</td><td>%llu</td></tr>", Run.timing.overruns);
+        StringBuffer_append(res->outputbuffer, "<tr><td>Dropped log messages</td><td>%llu</td></tr>", Run.timing.logdropped);
+        if (Run.syslog.host)
+                StringBuffer_append(res->outputbuffer, "<tr><td>Syslog server</td><td>%llu sent, %llu dropped, %llu errors</td></tr>", Run.timing.syslogsent, Run.timing.syslogdropped, Run.timing.syslogerrors);
+        if (Run.httpd.credentials)
+                StringBuffer_append(res->outputbuffer, "<tr><td>Credential cache</td><td>%llu hits, %llu misses</td></tr>", Run.timing.credentialhits, Run.timing.credentialmisses);
+        if (Run.watchdog.timeout)
+                StringBuffer_append(res->outputbuffer, "<tr><td>Watchdog</td><td>timeout %d seconds%s, %llu stalled checks</td></tr>", Run.watchdog.timeout, Run.watchdog.isolate ? ", isolate stalled services" : "", Run.timing.stalls);
+        else
+                StringBuffer_append(res->outputbuffer, "<tr><td>Watchdog</td><td>disabled</td></tr>");
         if (Run.httpd.flags & Httpd_Net) {
                 StringBuffer_append(res->outputbuffer,
                                     "<tr><td>httpd bind address</td><td>%s</td></tr>",
@@ -886,42 +957,189 @@ static void do_runtime(HttpRequest req, HttpResponse res) {
 }
 
 
+/**
+ * Return the numeric request parameter or the default value if the parameter is missing or invalid
+ */
+static long long _getNumericParameter(HttpRequest req, const char *name, long long value) {
+        const char *p = get_parameter(req, name);
+        if (STR_DEF(p)) {
+                char *end;
+                long long v = strtoll(p, &end, 10);
+                if (! *end && v >= 0)
+                        return v;
+        }
+        return value;
+}
+
+
+/**
+ * Find the offset where the last lines of the log file start by scanning
+ * the file backwards in blocks. At most LOGVIEW_LIMIT bytes are scanned
+ */
+static off_t _logTail(int fd, off_t size, long long lines) {
+        char block[LOGVIEW_BLOCK];
+        off_t limit = size > LOGVIEW_LIMIT ? size - LOGVIEW_LIMIT : 0;
+        if (lines == 0)
+                return size;
+        for (off_t end = size; end > limit;) {
+                off_t start = end - LOGVIEW_BLOCK > limit ? end - LOGVIEW_BLOCK : limit;
+                ssize_t n = pread(fd, block, end - start, start);
+                if (n <= 0)
+                        break;
+                for (ssize_t i = n - 1; i >= 0; i--) {
+                        // The newline at the end of the file terminates the last line
+                        if (block[i] == '\n' && start + i < size - 1 && --lines == 0)
+                                return start + i + 1;
+                }
+                end = start;
+        }
+        return limit;
+}
+
+
+/**
+ * Append the log file range to the response, the HTML output is escaped
+ * @return The offset where the reading stopped
+ */
+static off_t _logRange(int fd, off_t start, off_t end, Output_Type type, HttpResponse res) {
+        char block[LOGVIEW_BLOCK + 1];
+        while (start < end) {
+                ssize_t n = pread(fd, block, end - start < LOGVIEW_BLOCK ? end - start : LOGVIEW_BLOCK, start);
+                if (n <= 0)
+                        break;
+                if (type == HTML) {
+                        // escapeHTML() stops at NUL, escape the block by segments and skip the NUL bytes which the textarea can't show anyway
+                        block[n] = 0;
+                        for (char *p = block; p < block + n; p += strlen(p) + 1)
+                                escapeHTML(res->outputbuffer, p);
+                } else {
+                        StringBuffer_appendBytes(res->outputbuffer, block, (int)n);
+                }
+                start += n;
+        }
+        return start;
+}
+
+
+/**
+ * Show the log file. Only the last lines ("lines" parameter), or the byte
+ * range ("offset" and "length" parameters) are read, at most LOGVIEW_LIMIT
+ * bytes, so the memory used doesn't depend on the log size. With
+ * "format=text" the log is sent as plain text and the X-Monit-Log-Offset
+ * header holds the offset where to continue, so the client can follow the
+ * log by repeated requests with this offset. The HTML follow mode does so
+ * every LOGVIEW_FOLLOW milliseconds.
+ */
 static void do_viewlog(HttpRequest req, HttpResponse res) {
         if (is_readonly(req)) {
                 send_error(req, res, SC_FORBIDDEN, "You do not have sufficient privileges to access this page");
                 return;
         }
-        do_head(res, "_viewlog", "View log", 100);
+        const char *format = get_parameter(req, "format");
+        Output_Type type = format && Str_startsWith(format, "text") ? TXT : HTML;
+        boolean_t follow = get_parameter(req, "follow") ? true : false;
+        long long lines = _getNumericParameter(req, "lines", LOGVIEW_LINES);
+        if (type == TXT) {
+                set_content_type(res, "text/plain");
+        } else {
+                do_head(res, "_viewlog", "View log", follow ? 3600 : 100);
+        }
         if ((Run.flags & Run_Log) && ! (Run.flags & Run_UseSyslog)) {
-                struct stat sb;
-                if (! stat(Run.files.log, &sb)) {
-                        FILE *f = fopen(Run.files.log, "r");
-                        if (f) {
-#define BUFSIZE 512
-                                size_t n;
-                                char buf[BUFSIZE+1];
-                                StringBuffer_append(res->outputbuffer, "<br><p><form><textarea cols=120 rows=30 readonly>");
-                                while ((n = fread(buf, sizeof(char), BUFSIZE, f)) > 0) {
-                                        buf[n] = 0;
-                                        StringBuffer_append(res->outputbuffer, "%s", buf);
+                int fd = open(Run.files.log, O_RDONLY);
+                if (fd >= 0) {
+                        struct stat sb;
+                        if (! fstat(fd, &sb)) {
+                                off_t start, end = sb.st_size;
+                                long long offset = _getNumericParameter(req, "offset", -1);
+                                if (offset >= 0) {
+                                        // The log was truncated or rotated => start from the beginning
+                                        start = offset <= sb.st_size ? offset : 0;
+                                        long long length = _getNumericParameter(req, "length", LOGVIEW_LIMIT);
+                                        if (length < end - start)
+                                                end = start + length;
+                                } else {
+                                        start = _logTail(fd, sb.st_size, lines);
                                 }
-                                fclose(f);
-                                StringBuffer_append(res->outputbuffer, "</textarea></form>");
+                                if (end - start > LOGVIEW_LIMIT)
+                                        end = start + LOGVIEW_LIMIT;
+                                if (type == TXT) {
+                                        end = _logRange(fd, start, end, type, res);
+                                        set_header(res, "X-Monit-Log-Offset", "%lld", (long long)end);
+                                        set_header(res, "X-Monit-Log-Size", "%lld", (long long)sb.st_size);
+                                } else {
+                                        StringBuffer_append(res->outputbuffer,
+                                                            "<br><p><form method=GET action='_viewlog'>Last "
+                                                            "<input type=text name=lines size=6 value='%lld'> lines "
+                                                            "<input type=checkbox name=follow value=1%s> follow "
+                                                            "<input type=submit value='Show'></form>"
+                                                            "<p><textarea id='log' cols=120 rows=30 readonly>",
+                                                            lines, follow ? " checked" : "");
+                                        end = _logRange(fd, start, end, type, res);
+                                        StringBuffer_append(res->outputbuffer, "</textarea>");
+                                        if (follow)
+                                                StringBuffer_append(res->outputbuffer,
+                                                                    "<script>"
+                                                                    "var offset = %lld, log = document.getElementById('log');"
+                                                                    "log.scrollTop = log.scrollHeight;"
+                                                                    "function follow() {"
+                                                                    " var r = new XMLHttpRequest();"
+                                                                    " r.open('GET', '_viewlog?format=text&offset=' + offset);"
+                                                                    " r.onload = function() {"
+                                                                    "  var next = parseInt(r.getResponseHeader('X-Monit-Log-Offset'));"
+                                                                    "  if (r.status == 200 && ! isNaN(next)) {"
+                                                                    "   if (next < offset) log.value = '';"
+                                                                    "   offset = next;"
+                                                                    "   if (r.responseText.length) {"
+                                                                    "    log.value = (log.value + r.responseText).slice(-%d);"
+                                                                    "    log.scrollTop = log.scrollHeight;"
+                                                                    "   }"
+                                                                    "  }"
+                                                                    "  setTimeout(follow, %d);"
+                                                                    " };"
+                                                                    " r.onerror = function() { setTimeout(follow, %d); };"
+                                                                    " r.send();"
+                                                                    "}"
+                                                                    "setTimeout(follow, %d);"
+                                                                    "</script>",
+                                                                    (long long)end, LOGVIEW_LIMIT, LOGVIEW_FOLLOW, LOGVIEW_FOLLOW, LOGVIEW_FOLLOW);
+                                }
+                        } else if (type == TXT) {
+                                // The text output is read by the follow client, report the errors by the status, so they are not taken for the log content
+                                send_error(req, res, SC_INTERNAL_SERVER_ERROR, "Error stating logfile: %s", STRERROR);
                         } else {
-                                StringBuffer_append(res->outputbuffer, "Error opening logfile: %s", STRERROR);
+                                StringBuffer_append(res->outputbuffer, "Error stating logfile: %s", STRERROR);
                         }
+                        close(fd);
+                } else if (type == TXT) {
+                        send_error(req, res, SC_INTERNAL_SERVER_ERROR, "Error opening logfile: %s", STRERROR);
                 } else {
-                        StringBuffer_append(res->outputbuffer, "Error stating logfile: %s", STRERROR);
+                        StringBuffer_append(res->outputbuffer, "Error opening logfile: %s", STRERROR);
                 }
+        } else if (type == TXT) {
+                send_error(req, res, SC_NOT_FOUND, "Cannot view logfile: %s", ! (Run.flags & Run_Log) ? "Monit was started without logging" : "Monit uses syslog");
         } else {
-                StringBuffer_append(res->outputbuffer,
-                                    "<b>Cannot view logfile:</b><br>");
+                StringBuffer_append(res->outputbuffer, "<b>Cannot view logfile:</b><br>");
                 if (! (Run.flags & Run_Log))
                         StringBuffer_append(res->outputbuffer, "Monit was started without logging");
                 else
                         StringBuffer_append(res->outputbuffer, "Monit uses syslog");
         }
-        do_foot(res);
+        if (type == HTML)
+                do_foot(res);
+}
+
+
+/**
+ * Hand over the connection to the Server-Sent Events stream of the service state changes and actions
+ */
+static void do_events(HttpRequest req, HttpResponse res) {
+        if (EventStream_subscribe(res->S, get_known_header(req, Header_LastEventId))) {
+                // The event stream writes the response
+                res->is_committed = true;
+                res->is_detached = true;
+        } else {
+                send_error(req, res, SC_SERVICE_UNAVAILABLE, "Too many event stream subscribers");
+        }
 }
 
 
@@ -1118,6 +1336,11 @@ static void do_service(HttpRequest req, HttpResponse res, Service_T s) {
                         StringBuffer_append(res->outputbuffer, "every <code>\"%s\"</code>", s->every.spec.cron);
                 else if (s->every.type == Every_NotInCron)
                         StringBuffer_append(res->outputbuffer, "not every <code>\"%s\"</code>", s->every.spec.cron);
+                else if (s->every.type == Every_Interval) {
+                        StringBuffer_append(res->outputbuffer, "every %s", Str_milliToTime(s->every.spec.interval.base, (char[23]){}));
+                        if (s->every.spec.interval.max)
+                                StringBuffer_append(res->outputbuffer, " adaptive to %s (current interval %s)", Str_milliToTime(s->every.spec.interval.max, (char[23]){}), Str_milliToTime(s->every.spec.interval.current, (char[23]){}));
+                }
                 StringBuffer_append(res->outputbuffer, "</td></tr>");
         }
         _printStatus(HTML, res, s);
@@ -1274,6 +1497,7 @@ static void do_home_process(HttpResponse res) {
                 }
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1327,7 +1551,7 @@ static void do_home_program(HttpResponse res) {
                                                 else if (output[i] == '\r' || output[i] == '\n')
                                                         break;
                                                 else
-                                                        StringBuffer_append(res->outputbuffer, "%c", output[i]);
+                                                        StringBuffer_appendChar(res->outputbuffer, output[i]);
                                         }
                                 } else {
                                         StringBuffer_append(res->outputbuffer, "no output");
@@ -1343,6 +1567,7 @@ static void do_home_program(HttpResponse res) {
                 }
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1385,6 +1610,7 @@ static void do_home_net(HttpResponse res) {
                 }
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1451,6 +1677,7 @@ static void do_home_filesystem(HttpResponse res) {
                 }
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1504,6 +1731,7 @@ static void do_home_file(HttpResponse res) {
                         StringBuffer_append(res->outputbuffer, "<td class='right'>%d</td>", s->inf.file->gid);
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1551,6 +1779,7 @@ static void do_home_fifo(HttpResponse res) {
                         StringBuffer_append(res->outputbuffer, "<td class='right'>%d</td>", s->inf.fifo->gid);
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1598,6 +1827,7 @@ static void do_home_directory(HttpResponse res) {
                         StringBuffer_append(res->outputbuffer, "<td class='right'>%d</td>", s->inf.directory->gid);
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -1674,6 +1904,7 @@ static void do_home_host(HttpResponse res) {
                 }
                 StringBuffer_append(res->outputbuffer, "</tr>");
                 on = ! on;
+                flush_response(res);
         }
         if (! header)
                 StringBuffer_append(res->outputbuffer, "</table>");
@@ -2219,6 +2450,18 @@ static void print_service_rules_resource(HttpResponse res, Service_T s) {
                                 StringBuffer_append(res->outputbuffer, "CPU wait limit");
                                 break;
 
+                        case Resource_CpuSteal:
+                                StringBuffer_append(res->outputbuffer, "CPU steal limit");
+                                break;
+
+                        case Resource_CpuGuest:
+                                StringBuffer_append(res->outputbuffer, "CPU guest limit");
+                                break;
+
+                        case Resource_CpuCore:
+                                StringBuffer_append(res->outputbuffer, "CPU core limit");
+                                break;
+
                         case Resource_MemoryPercent:
                                 StringBuffer_append(res->outputbuffer, "Memory usage limit");
                                 break;
@@ -2290,6 +2533,9 @@ static void print_service_rules_resource(HttpResponse res, Service_T s) {
                         case Resource_CpuUser:
                         case Resource_CpuSystem:
                         case Resource_CpuWait:
+                        case Resource_CpuSteal:
+                        case Resource_CpuGuest:
+                        case Resource_CpuCore:
                         case Resource_MemoryPercent:
                         case Resource_SwapPercent:
                                 Util_printRule(res->outputbuffer, q->action, "If %s %.1f%%", operatornames[q->operator], q->limit);
@@ -2347,13 +2593,11 @@ static void print_status(HttpRequest req, HttpResponse res, int version) {
         const char *stringFormat = get_parameter(req, "format");
         if (stringFormat && Str_startsWith(stringFormat, "xml")) {
                 char buf[STRLEN];
-                StringBuffer_T sb = StringBuffer_create(256);
-                status_xml(sb, NULL, version, Socket_getLocalHost(req->S, buf, sizeof(buf)));
-                StringBuffer_append(res->outputbuffer, "%s", StringBuffer_toString(sb));
-                StringBuffer_free(&sb);
+                status_xml(res->outputbuffer, NULL, version, Socket_getLocalHost(req->S, buf, sizeof(buf)));
                 set_content_type(res, "text/xml");
         } else {
                 set_content_type(res, "text/plain");
+                set_streaming(req, res);
 
                 StringBuffer_append(res->outputbuffer, "Monit %s uptime: %s\n\n", VERSION, _getUptime(ProcessTree_getProcessUptime(getpid()), (char[256]){}));
 
@@ -2361,21 +2605,23 @@ static void print_status(HttpRequest req, HttpResponse res, int version) {
                 const char *stringGroup = Util_urlDecode((char *)get_parameter(req, "group"));
                 const char *stringService = Util_urlDecode((char *)get_parameter(req, "service"));
                 if (stringGroup) {
-                        for (ServiceGroup_T sg = servicegrouplist; sg; sg = sg->next) {
-                                if (IS(stringGroup, sg->name)) {
-                                        for (list_t m = sg->members->head; m; m = m->next) {
-                                                status_service_txt(m->e, res);
-                                                found++;
-                                        }
-                                        break;
+                        ServiceGroup_T sg = Util_getServiceGroup(stringGroup);
+                        if (sg) {
+                                for (list_t m = sg->members->head; m; m = m->next) {
+                                        status_service_txt(m->e, res);
+                                        found++;
                                 }
                         }
+                } else if (stringService) {
+                        Service_T s = Util_getService(stringService);
+                        if (s) {
+                                status_service_txt(s, res);
+                                found++;
+                        }
                 } else {
                         for (Service_T s = servicelist_conf; s; s = s->next_conf) {
-                                if (! stringService || IS(stringService, s->name)) {
-                                        status_service_txt(s, res);
-                                        found++;
-                                }
+                                status_service_txt(s, res);
+                                found++;
                         }
                 }
                 if (found == 0) {
@@ -2424,21 +2670,18 @@ static void print_summary(HttpRequest req, HttpResponse res) {
                         {.name = "Type",         .width = 13, .wrap = false, .align = BoxAlign_Left}
                   }, true);
         if (stringGroup) {
-                for (ServiceGroup_T sg = servicegrouplist; sg; sg = sg->next) {
-                        if (IS(stringGroup, sg->name)) {
-                                for (list_t m = sg->members->head; m; m = m->next) {
-                                        _printServiceSummary(t, m->e);
-                                        found++;
-                                }
-                                break;
+                ServiceGroup_T sg = Util_getServiceGroup(stringGroup);
+                if (sg) {
+                        for (list_t m = sg->members->head; m; m = m->next) {
+                                _printServiceSummary(t, m->e);
+                                found++;
                         }
                 }
         } else if (stringService) {
-                for (Service_T s = servicelist_conf; s; s = s->next_conf) {
-                        if (IS(stringService, s->name)) {
-                                _printServiceSummary(t, s);
-                                found++;
-                        }
+                Service_T s = Util_getService(stringService);
+                if (s) {
+                        _printServiceSummary(t, s);
+                        found++;
                 }
         } else {
                 found += _printServiceSummaryByType(t, Service_System);
@@ -2521,6 +2764,37 @@ static void _printReport(HttpRequest req, HttpResponse res) {
 }
 
 
+static void _printStats(HttpRequest req, HttpResponse res) {
+        set_content_type(res, "text/plain");
+        StringBuffer_append(res->outputbuffer, "%-24s %10s %12s %12s %12s", "Stage", "Count", "Last", "Average", "Max");
+        for (int i = 0; i < TIMING_BUCKETS; i++)
+                StringBuffer_append(res->outputbuffer, " %7s", timingnames[i]);
+        StringBuffer_append(res->outputbuffer, "\n");
+        _printTiming(TXT, res, "cycle", &Run.timing.cycle);
+        _printTiming(TXT, res, "event queue", &Run.timing.events);
+        _printTiming(TXT, res, "system info update", &Run.timing.system);
+        _printTiming(TXT, res, "process tree update", &Run.timing.processes);
+        _printTiming(TXT, res, "state save", &Run.timing.state);
+        _printTiming(TXT, res, "control file parse", &Run.timing.parse);
+        StringBuffer_append(res->outputbuffer, "\nCycles exceeding the poll time (%ds): %llu\n", Run.polltime, Run.timing.overruns);
+        if (Run.watchdog.timeout)
+                StringBuffer_append(res->outputbuffer, "Checks exceeding the watchdog timeout (%ds): %llu\n", Run.watchdog.timeout, Run.timing.stalls);
+        if (Run.timing.logdropped)
+                StringBuffer_append(res->outputbuffer, "Log messages dropped on log queue overflow: %llu\n", Run.timing.logdropped);
+        if (Run.syslog.host)
+                StringBuffer_append(res->outputbuffer, "Syslog server messages: %llu sent, %llu dropped, %llu errors\n", Run.timing.syslogsent, Run.timing.syslogdropped, Run.timing.syslogerrors);
+        if (Run.httpd.credentials)
+                StringBuffer_append(res->outputbuffer, "HTTP credential cache: %llu hits, %llu misses\n", Run.timing.credentialhits, Run.timing.credentialmisses);
+        StringBuffer_append(res->outputbuffer, "\n");
+        StringBuffer_append(res->outputbuffer, "%-24s %10s %12s %12s %12s", "Service check", "Count", "Last", "Average", "Max");
+        for (int i = 0; i < TIMING_BUCKETS; i++)
+                StringBuffer_append(res->outputbuffer, " %7s", timingnames[i]);
+        StringBuffer_append(res->outputbuffer, "\n");
+        for (Service_T s = servicelist_conf; s; s = s->next_conf)
+                _printTiming(TXT, res, s->name, &s->timing);
+}
+
+
 static void status_service_txt(Service_T s, HttpResponse res) {
         char buf[STRLEN];
         StringBuffer_append(res->outputbuffer,
@@ -2539,6 +2813,7 @@ static void status_service_txt(Service_T s, HttpResponse res) {
                 "on reboot", onrebootnames[s->onreboot]);
         _printStatus(TXT, res, s);
         StringBuffer_append(res->outputbuffer, "\n");
+        flush_response(res);
 }
 
 
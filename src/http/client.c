@@ -256,3 +256,11 @@ boolean_t HttpClient_summary(const char *group, const char *service) {
         return rv;
 }
 
+
+boolean_t HttpClient_stats() {
+        StringBuffer_T data = StringBuffer_create(64);
+        boolean_t rv = _client("/_stats", data);
+        StringBuffer_free(&data);
+        return rv;
+}
+
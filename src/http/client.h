@@ -61,4 +61,12 @@ boolean_t HttpClient_status(const char *group, const char *service);
 boolean_t HttpClient_summary(const char *group, const char *service);
 
 
+/**
+ * Print Monit self-instrumentation statistics: duration of the
+ * validation stages and service checks
+ * @return true if succeeded otherwise false
+ */
+boolean_t HttpClient_stats();
+
+
 #endif
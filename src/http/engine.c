@@ -94,6 +94,7 @@
 
 // libmonit
 #include "system/Net.h"
+#include "system/Time.h"
 #include "exceptions/AssertException.h"
 #include "exceptions/IOException.h"
 
@@ -112,7 +113,14 @@
  *    promptly. The authentication schema or access control is based
  *    on client name/address/pam and only requests from known clients are
  *    accepted. Hosts allowed to connect to this server should be
- *    added to the access control list by calling Engine_addHostAllow().
+ *    added to the access control list by calling Engine_addAllow().
+ *
+ *    The access control list is compiled into a binary radix trie over
+ *    the IPv6 address space (IPv4 addresses are mapped to ::ffff:x.x.x.x),
+ *    so a lookup costs at most one step per prefix bit regardless of the
+ *    number of entries. Host names are resolved into a separate trie,
+ *    which is refreshed periodically by a resolver thread while the
+ *    server is running.
  *
  *  @file
  */
@@ -129,8 +137,25 @@ typedef struct HostsAllow_T {
 } *HostsAllow_T;
 
 
+typedef struct AllowNode_T {
+        boolean_t allow;                 // The prefix ending at this node is allowed
+        struct AllowNode_T *child[2];
+} *AllowNode_T;
+
+
+typedef struct AllowHost_T {
+        char *name;
+        int count;                       // Number of resolved addresses
+        uint32_t *addresses;             // Resolved addresses, 4 words each
+        /* For internal use */
+        struct AllowHost_T *next;
+} *AllowHost_T;
+
+
 #define MAX_SERVER_SOCKETS 3
 
+#define ALLOW_REFRESH 300 // Host name resolution refresh interval [s]
+
 
 static struct {
         Socket_Family family;
@@ -149,38 +174,115 @@ static struct {
 static volatile boolean_t stopped = false;
 static int myServerSocketsCount = 0;
 static struct pollfd myServerSockets[3] = {};
-static HostsAllow_T allowlist = NULL;
+static struct {
+        boolean_t initialized;
+        boolean_t running;
+        AllowNode_T networks;            // Compiled network and address entries
+        HostsAllow_T masks;              // Networks with non-contiguous mask, matched linearly
+        AllowHost_T hosts;               // Host name entries
+        AllowNode_T resolved;            // Compiled host addresses, replaced by the resolver under the mutex
+        Thread_T thread;
+        Sem_T cond;
+        Mutex_T mutex;
+} acl = {};
 
 
 /* ----------------------------------------------------------------- Private */
 
 
+static inline int _bit(uint32_t address[4], int index) {
+        // The address is in network byte order, bit 0 is the most significant bit of the first byte
+        return (((unsigned char *)address)[index / 8] >> (7 - index % 8)) & 1;
+}
+
+
+/**
+ * Return the prefix length of the mask or -1 if the mask is not contiguous
+ */
+static int _prefixLength(uint32_t mask[4]) {
+        int prefix = 0;
+        while (prefix < 128 && _bit(mask, prefix))
+                prefix++;
+        for (int i = prefix; i < 128; i++)
+                if (_bit(mask, i))
+                        return -1;
+        return prefix;
+}
+
+
+/**
+ * Add the prefix to the trie. Return false if the prefix was present already
+ */
+static boolean_t _trieInsert(AllowNode_T *root, uint32_t address[4], int prefix) {
+        if (! *root)
+                NEW(*root);
+        AllowNode_T node = *root;
+        for (int i = 0; i < prefix; i++) {
+                int bit = _bit(address, i);
+                if (! node->child[bit])
+                        NEW(node->child[bit]);
+                node = node->child[bit];
+        }
+        if (node->allow)
+                return false;
+        node->allow = true;
+        return true;
+}
+
+
+static boolean_t _trieMatch(AllowNode_T node, uint32_t address[4]) {
+        for (int i = 0; node; i++) {
+                if (node->allow)
+                        return true;
+                if (i == 128)
+                        break;
+                node = node->child[_bit(address, i)];
+        }
+        return false;
+}
+
+
+static void _trieFree(AllowNode_T *node) {
+        if (*node) {
+                _trieFree(&(*node)->child[0]);
+                _trieFree(&(*node)->child[1]);
+                FREE(*node);
+        }
+}
+
+
 static boolean_t _hasAllow(HostsAllow_T host) {
-        for (HostsAllow_T p = allowlist; p; p = p->next)
+        for (HostsAllow_T p = acl.masks; p; p = p->next)
                 if (memcmp(p->address, &(host->address), 16) == 0 && memcmp(p->mask, &(host->mask), 16) == 0)
                         return true;
         return false;
 }
 
 
-static void _pushAllow(HostsAllow_T h, const char *pattern) {
-        char buf[INET6_ADDRSTRLEN] = {};
-        if (! Str_sub(pattern, "/"))
-                inet_ntop(AF_INET6, &(h->address), buf, sizeof(buf));
-        if (_hasAllow(h))  {
-                if (*buf)
-                        LogWarning("Skipping 'allow %s' -- host resolved to [%s] which is present in ACL already\n", pattern, buf);
-                else
-                        LogWarning("Skipping 'allow %s' -- present in ACL already\n", pattern);
-                FREE(h);
-        } else {
-                if (*buf)
-                        DEBUG("Adding 'allow %s' -- host resolved to [%s]\n", pattern, buf);
-                else
-                        DEBUG("Adding 'allow %s'\n", pattern);
-                h->next = allowlist;
-                allowlist = h;
+static HostsAllow_T _copyAllow(HostsAllow_T source) {
+        HostsAllow_T copy;
+        NEW(copy);
+        memcpy(copy, source, sizeof(struct HostsAllow_T));
+        return copy;
+}
+
+
+static void _pushAllow(HostsAllow_T net, const char *pattern) {
+        boolean_t added = false;
+        int prefix = _prefixLength(net->mask);
+        if (prefix >= 0) {
+                added = _trieInsert(&acl.networks, net->address, prefix);
+        } else if (! _hasAllow(net)) {
+                // A non-contiguous mask cannot be expressed as a prefix
+                HostsAllow_T h = _copyAllow(net);
+                h->next = acl.masks;
+                acl.masks = h;
+                added = true;
         }
+        if (added)
+                DEBUG("Adding 'allow %s'\n", pattern);
+        else
+                LogWarning("Skipping 'allow %s' -- present in ACL already\n", pattern);
 }
 
 
@@ -193,24 +295,26 @@ static boolean_t _matchAllow(uint32_t address1[4], uint32_t address2[4], uint32_
 
 
 static boolean_t _isAllowed(uint32_t address[4]) {
-        if (allowlist) {
-                for (HostsAllow_T p = allowlist; p; p = p->next)
+        if (Engine_hasAllow()) {
+                if (_trieMatch(acl.networks, address))
+                        return true;
+                for (HostsAllow_T p = acl.masks; p; p = p->next)
                         if (_matchAllow(p->address, address, p->mask))
                                 return true;
-                return false;
+                boolean_t allowed = false;
+                if (acl.hosts) {
+                        LOCK(acl.mutex)
+                        {
+                                allowed = _trieMatch(acl.resolved, address);
+                        }
+                        END_LOCK;
+                }
+                return allowed;
         }
         return true;
 }
 
 
-static HostsAllow_T _copyAllow(HostsAllow_T source) {
-        HostsAllow_T copy;
-        NEW(copy);
-        memcpy(copy, source, sizeof(struct HostsAllow_T));
-        return copy;
-}
-
-
 static void _mapIPv4toIPv6(uint32_t *address4, uint32_t *address6) {
         // Map IPv4 address to IPv6 "::ffff:x.x.x.x" notation, so we can compare IPv4 address in IPv6 namespace
         *(address6 + 0) = 0x00000000;
@@ -331,42 +435,146 @@ static boolean_t _parseNetwork(char *pattern) {
                 if (! inet_aton(longmask, &(addr.sin_addr)))
                         return false;
                 _mapIPv4toIPv6((uint32_t *)&(addr.sin_addr), net.mask);
+                // Match the whole ::ffff:0:0/96 IPv4 mapping prefix, so contiguous masks compile to a prefix
+                memset(net.mask, 0xff, 12);
         }
-        _pushAllow(_copyAllow(&net), pattern);
+        _pushAllow(&net, pattern);
         return true;
 }
 
 
-//FIXME: don't store the translated hostname->IPaddress on Monit startup to support DHCP hosts ... resolve the hostname in _authenticateHost()
-static boolean_t _parseHost(char *pattern) {
+/**
+ * Resolve the host name. Return the addresses (4 words each) or NULL if the name cannot be resolved
+ */
+static uint32_t *_resolveHost(const char *name, int *count) {
         struct addrinfo *res, hints = {
                 .ai_protocol = IPPROTO_TCP
         };
-        int added = 0;
-        if (! getaddrinfo(pattern, NULL, &hints, &res)) {
+        uint32_t *addresses = NULL;
+        *count = 0;
+        if (! getaddrinfo(name, NULL, &hints, &res)) {
                 for (struct addrinfo *_res = res; _res; _res = _res->ai_next) {
-                        HostsAllow_T h = NULL;
+                        uint32_t address[4];
                         if (_res->ai_family == AF_INET) {
-                                NEW(h);
                                 struct sockaddr_in *sin = (struct sockaddr_in *)_res->ai_addr;
-                                _mapIPv4toIPv6((uint32_t *)&(sin->sin_addr), h->address);
+                                _mapIPv4toIPv6((uint32_t *)&(sin->sin_addr), address);
                         }
 #ifdef HAVE_IPV6
                         else if (_res->ai_family == AF_INET6) {
-                                NEW(h);
                                 struct sockaddr_in6 *sin = (struct sockaddr_in6 *)_res->ai_addr;
-                                memcpy(&h->address, &(sin->sin6_addr), 16);
+                                memcpy(address, &(sin->sin6_addr), 16);
                         }
 #endif
-                        if (h) {
-                                memset(h->mask, 0xff, 16); // compare all 128 bits
-                                _pushAllow(h, pattern);
-                                added++;
+                        else {
+                                continue;
                         }
+                        RESIZE(addresses, (*count + 1) * sizeof(address));
+                        memcpy(addresses + *count * 4, address, sizeof(address));
+                        (*count)++;
                 }
                 freeaddrinfo(res);
         }
-        return added ? true : false;
+        return addresses;
+}
+
+
+static boolean_t _parseHost(char *pattern) {
+        for (AllowHost_T h = acl.hosts; h; h = h->next) {
+                if (IS(h->name, pattern)) {
+                        LogWarning("Skipping 'allow %s' -- present in ACL already\n", pattern);
+                        return true;
+                }
+        }
+        int count;
+        uint32_t *addresses = _resolveHost(pattern, &count);
+        if (! addresses)
+                return false;
+        AllowHost_T h;
+        NEW(h);
+        h->name = Str_dup(pattern);
+        h->count = count;
+        h->addresses = addresses;
+        h->next = acl.hosts;
+        acl.hosts = h;
+        for (int i = 0; i < count; i++) {
+                _trieInsert(&acl.resolved, addresses + i * 4, 128);
+                DEBUG("Adding 'allow %s' -- host resolved to [%s]\n", pattern, inet_ntop(AF_INET6, addresses + i * 4, (char[INET6_ADDRSTRLEN]){}, INET6_ADDRSTRLEN));
+        }
+        return true;
+}
+
+
+/**
+ * Resolve all host names again and compile the addresses. A host which
+ * cannot be resolved keeps the addresses from the previous resolution
+ */
+static AllowNode_T _refreshHosts() {
+        AllowNode_T resolved = NULL;
+        for (AllowHost_T h = acl.hosts; h; h = h->next) {
+                int count;
+                uint32_t *addresses = _resolveHost(h->name, &count);
+                if (addresses) {
+                        FREE(h->addresses);
+                        h->addresses = addresses;
+                        h->count = count;
+                } else {
+                        LogWarning("Cannot resolve 'allow %s' -- keeping the previously resolved addresses\n", h->name);
+                }
+                for (int i = 0; i < h->count; i++)
+                        _trieInsert(&resolved, h->addresses + i * 4, 128);
+        }
+        return resolved;
+}
+
+
+static void *_resolver(void *args) {
+        set_signal_block();
+        LOCK(acl.mutex)
+        {
+                while (acl.running) {
+                        time_t refresh = Time_now() + ALLOW_REFRESH;
+                        while (acl.running && Time_now() < refresh) {
+                                struct timespec wait = {.tv_sec = refresh, .tv_nsec = 0};
+                                Sem_timeWait(acl.cond, acl.mutex, wait);
+                        }
+                        if (acl.running) {
+                                // The host list is modified only while the server is stopped => resolve unlocked, so lookups are not blocked by DNS
+                                Mutex_unlock(acl.mutex);
+                                AllowNode_T resolved = _refreshHosts();
+                                Mutex_lock(acl.mutex);
+                                _trieFree(&acl.resolved);
+                                acl.resolved = resolved;
+                        }
+                }
+        }
+        END_LOCK;
+        return NULL;
+}
+
+
+static void _startResolver() {
+        if (! acl.initialized) {
+                Mutex_init(acl.mutex);
+                Sem_init(acl.cond);
+                acl.initialized = true;
+        }
+        if (acl.hosts) {
+                acl.running = true;
+                Thread_create(acl.thread, _resolver, NULL);
+        }
+}
+
+
+static void _stopResolver() {
+        if (acl.running) {
+                LOCK(acl.mutex)
+                {
+                        acl.running = false;
+                        Sem_signal(acl.cond);
+                }
+                END_LOCK;
+                Thread_join(acl.thread);
+        }
 }
 
 
@@ -479,11 +687,13 @@ void Engine_start() {
                         if (STR_DEF(error[i]))
                                 LogError("HTTP server -- %s\n", error[i]);
         } else {
+                _startResolver();
                 while (! stopped) {
                         Socket_T S = _socketProducer();
                         if (S)
                                 http_processor(S);
                 }
+                _stopResolver();
                 for (int i = 0; i < myServerSocketsCount; i++) {
 #ifdef HAVE_OPENSSL
                         if (data[i].ssl)
@@ -517,15 +727,24 @@ boolean_t Engine_addAllow(char *pattern) {
 
 
 boolean_t Engine_hasAllow() {
-        return allowlist ? true : false;
+        return (acl.networks || acl.masks || acl.hosts) ? true : false;
 }
 
 
 void Engine_destroyAllow() {
-        for (HostsAllow_T current = allowlist, next = NULL; current; current = next) {
+        _trieFree(&acl.networks);
+        _trieFree(&acl.resolved);
+        for (HostsAllow_T current = acl.masks, next = NULL; current; current = next) {
+                next = current->next;
+                FREE(current);
+        }
+        acl.masks = NULL;
+        for (AllowHost_T current = acl.hosts, next = NULL; current; current = next) {
                 next = current->next;
+                FREE(current->name);
+                FREE(current->addresses);
                 FREE(current);
         }
-        allowlist = NULL;
+        acl.hosts = NULL;
 }
 
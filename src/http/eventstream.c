@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+#include "config.h"
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#ifdef HAVE_STDARG_H
+#include <stdarg.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "monit.h"
+#include "event.h"
+#include "processor.h"
+#include "eventstream.h"
+
+// libmonit
+#include "system/Time.h"
+#include "exceptions/AssertException.h"
+
+
+/**
+ * Implementation of the Server-Sent Events stream, see eventstream.h
+ *
+ * @file
+ */
+
+
+/* ------------------------------------------------------------- Definitions */
+
+
+#define EVENTSTREAM_RING        256            /* Records kept for the subscribers */
+#define EVENTSTREAM_RECORD      1024   /* Record size limit, the message is truncated */
+#define EVENTSTREAM_SUBSCRIBERS 32                              /* Subscribers limit */
+#define EVENTSTREAM_BUFFER      16384     /* Data written to a subscriber at once */
+#define EVENTSTREAM_KEEPALIVE   15                   /* Keepalive comment interval [s] */
+#define EVENTSTREAM_TIMEOUT     1000                 /* Subscriber write timeout [ms] */
+
+
+typedef struct EventRecord_T {
+        unsigned long long id;
+        int length;
+        char data[EVENTSTREAM_RECORD];
+} *EventRecord_T;
+
+
+typedef struct Subscriber_T {
+        Socket_T socket;
+        boolean_t started;                       /**< The response header was sent */
+        unsigned long long cursor;                   /**< Id of the next record to send */
+} *Subscriber_T;
+
+
+static struct {
+        boolean_t initialized;
+        boolean_t running;
+        unsigned long long head;                       /**< Id of the next posted record */
+        Thread_T thread;
+        Sem_T cond;
+        Mutex_T mutex;
+        struct Subscriber_T subscribers[EVENTSTREAM_SUBSCRIBERS];
+        struct EventRecord_T ring[EVENTSTREAM_RING];
+} _stream = {.head = 1};
+
+
+/* ----------------------------------------------------------------- Private */
+
+
+static void _append(EventRecord_T r, const char *s, ...) __attribute__((format (printf, 2, 3)));
+static void _append(EventRecord_T r, const char *s, ...) {
+        va_list ap;
+        va_start(ap, s);
+        int n = vsnprintf(r->data + r->length, sizeof(r->data) - r->length, s, ap);
+        va_end(ap);
+        if (n > 0)
+                r->length = r->length + n < (int)sizeof(r->data) ? r->length + n : (int)sizeof(r->data) - 1;
+}
+
+
+/**
+ * Append the JSON string member. The value is truncated if the record is full, the space for the record end is kept
+ */
+static void _appendString(EventRecord_T r, const char *name, const char *value) {
+        _append(r, ",\"%s\":\"", name);
+        for (const unsigned char *s = (const unsigned char *)(value ? value : ""); *s && r->length < (int)sizeof(r->data) - 32; s++) {
+                if (*s == '"' || *s == '\\')
+                        _append(r, "\\%c", *s);
+                else if (*s == '\n')
+                        _append(r, "\\n");
+                else if (*s < 0x20)
+                        _append(r, "\\u%04x", *s);
+                else
+                        r->data[r->length++] = *s;
+        }
+        _append(r, "\"");
+}
+
+
+static void _post(const char *type, Service_T S, Event_T E, const char *action) {
+        if (_stream.initialized) {
+                LOCK(_stream.mutex)
+                {
+                        if (_stream.running) {
+                                EventRecord_T r = &_stream.ring[_stream.head % EVENTSTREAM_RING];
+                                r->id = _stream.head++;
+                                r->length = 0;
+                                _append(r, "id: %llu\nevent: %s\ndata: {\"time\":%lld", r->id, type, (long long)Time_now());
+                                _appendString(r, "service", S->name);
+                                _appendString(r, "type", servicetypes[S->type]);
+                                _appendString(r, "event", Event_get_description(E));
+                                _appendString(r, "state", E->state <= State_Init ? statenames[E->state] : NULL);
+                                _appendString(r, "action", action);
+                                _appendString(r, "message", E->message);
+                                _append(r, "}\n\n");
+                                Sem_signal(_stream.cond);
+                        }
+                }
+                END_LOCK;
+        }
+}
+
+
+static void _drop(Subscriber_T s) {
+        Socket_free(&s->socket);
+        s->started = false;
+}
+
+
+static boolean_t _hasPending() {
+        for (int i = 0; i < EVENTSTREAM_SUBSCRIBERS; i++)
+                if (_stream.subscribers[i].socket && (! _stream.subscribers[i].started || _stream.subscribers[i].cursor < _stream.head))
+                        return true;
+        return false;
+}
+
+
+/**
+ * Copy the response header and the pending records of the subscriber to the buffer and advance its cursor
+ * @return The data length or -1 if the subscriber is too slow, i.e. its next record was overwritten already
+ */
+static int _collect(Subscriber_T s, char *buffer, boolean_t keepalive) {
+        int length = 0;
+        if (! s->started) {
+                length = snprintf(buffer, EVENTSTREAM_BUFFER, "%s 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\nretry: 3000\n\n", SERVER_PROTOCOL);
+                s->started = true;
+        }
+        if (_stream.head - s->cursor > EVENTSTREAM_RING)
+                return -1;
+        for (; s->cursor < _stream.head; s->cursor++) {
+                EventRecord_T r = &_stream.ring[s->cursor % EVENTSTREAM_RING];
+                if (length + r->length > EVENTSTREAM_BUFFER)
+                        break;
+                memcpy(buffer + length, r->data, r->length);
+                length += r->length;
+        }
+        if (! length && keepalive)
+                length = snprintf(buffer, EVENTSTREAM_BUFFER, ": keepalive\n\n");
+        return length;
+}
+
+
+static void *_streamer(void *args) {
+        set_signal_block();
+        char *buffer = ALLOC(EVENTSTREAM_BUFFER);
+        time_t keepalive = Time_now() + EVENTSTREAM_KEEPALIVE;
+        LOCK(_stream.mutex)
+        {
+                while (_stream.running) {
+                        if (! _hasPending() && Time_now() < keepalive) {
+                                struct timespec wait = {.tv_sec = keepalive, .tv_nsec = 0};
+                                Sem_timeWait(_stream.cond, _stream.mutex, wait);
+                                continue;
+                        }
+                        boolean_t ping = Time_now() >= keepalive;
+                        for (int i = 0; i < EVENTSTREAM_SUBSCRIBERS && _stream.running; i++) {
+                                Subscriber_T s = &_stream.subscribers[i];
+                                if (s->socket) {
+                                        int length = _collect(s, buffer, ping);
+                                        if (length < 0) {
+                                                DEBUG("Event stream subscriber %s dropped -- too slow\n", Socket_getRemoteHost(s->socket));
+                                                _drop(s);
+                                        } else if (length > 0) {
+                                                // The slot is owned by this thread, only the subscribe fills free slots => the write may run unlocked
+                                                Mutex_unlock(_stream.mutex);
+                                                int rv = Socket_write(s->socket, buffer, length);
+                                                Mutex_lock(_stream.mutex);
+                                                if (rv < 0) {
+                                                        DEBUG("Event stream subscriber %s disconnected\n", Socket_getRemoteHost(s->socket));
+                                                        _drop(s);
+                                                }
+                                        }
+                                }
+                        }
+                        if (ping)
+                                keepalive = Time_now() + EVENTSTREAM_KEEPALIVE;
+                }
+                for (int i = 0; i < EVENTSTREAM_SUBSCRIBERS; i++)
+                        if (_stream.subscribers[i].socket)
+                                _drop(&_stream.subscribers[i]);
+        }
+        END_LOCK;
+        FREE(buffer);
+#ifdef HAVE_OPENSSL
+        Ssl_threadCleanup();
+#endif
+        return NULL;
+}
+
+
+/* ------------------------------------------------------------------ Public */
+
+
+void EventStream_start() {
+        if (! _stream.initialized) {
+                Mutex_init(_stream.mutex);
+                Sem_init(_stream.cond);
+                _stream.initialized = true;
+        }
+        LOCK(_stream.mutex)
+        {
+                _stream.running = true;
+        }
+        END_LOCK;
+        Thread_create(_stream.thread, _streamer, NULL);
+}
+
+
+void EventStream_stop() {
+        if (_stream.initialized) {
+                boolean_t running = false;
+                LOCK(_stream.mutex)
+                {
+                        running = _stream.running;
+                        _stream.running = false;
+                        Sem_signal(_stream.cond);
+                }
+                END_LOCK;
+                if (running)
+                        Thread_join(_stream.thread);
+        }
+}
+
+
+boolean_t EventStream_subscribe(Socket_T S, const char *lastEventId) {
+        ASSERT(S);
+        boolean_t subscribed = false;
+        if (_stream.initialized) {
+                LOCK(_stream.mutex)
+                {
+                        for (int i = 0; i < EVENTSTREAM_SUBSCRIBERS && _stream.running; i++) {
+                                Subscriber_T s = &_stream.subscribers[i];
+                                if (! s->socket) {
+                                        s->cursor = _stream.head;
+                                        if (STR_DEF(lastEventId)) {
+                                                // Resume after the last received record, or from the oldest record still in the ring
+                                                unsigned long long next = strtoull(lastEventId, NULL, 10) + 1;
+                                                unsigned long long oldest = _stream.head > EVENTSTREAM_RING ? _stream.head - EVENTSTREAM_RING : 1;
+                                                if (next < _stream.head)
+                                                        s->cursor = next > oldest ? next : oldest;
+                                        }
+                                        Socket_setTimeout(S, EVENTSTREAM_TIMEOUT);
+                                        s->started = false;
+                                        s->socket = S;
+                                        subscribed = true;
+                                        Sem_signal(_stream.cond);
+                                        break;
+                                }
+                        }
+                }
+                END_LOCK;
+        }
+        return subscribed;
+}
+
+
+void EventStream_postState(Service_T S, Event_T E) {
+        ASSERT(S);
+        ASSERT(E);
+        _post("state", S, E, Event_get_action_description(E));
+}
+
+
+void EventStream_postAction(Service_T S, Event_T E, Action_Type A) {
+        ASSERT(S);
+        ASSERT(E);
+        _post("action", S, E, actionnames[A]);
+}
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+#include "socket.h"
+
+
+/**
+ * Server-Sent Events stream of the service state changes and actions,
+ * served by the HTTP interface at /_events.
+ *
+ * The records are kept in a shared ring buffer; every subscriber has its
+ * own cursor in the ring, so any number of subscribers is served from one
+ * copy of the records. A dedicated thread writes the pending records to
+ * the subscribers, so the single HTTP thread is not held by the open
+ * connections. A subscriber which falls more than the ring size behind,
+ * or cannot take the data within the write timeout, is disconnected; the
+ * EventSource client reconnects and continues from its Last-Event-ID as
+ * long as the record is still in the ring.
+ *
+ *  @file
+ */
+
+
+/**
+ * Start the event stream thread
+ */
+void EventStream_start();
+
+
+/**
+ * Stop the event stream thread and close the subscriber connections
+ */
+void EventStream_stop();
+
+
+/**
+ * Hand over the HTTP connection to the event stream. The response header
+ * is written and the connection is kept open for the events
+ * @param S The client connection
+ * @param lastEventId The Last-Event-ID request header value or NULL
+ * @return true if the connection was added, false if the stream is not
+ * running or the subscribers limit was reached
+ */
+boolean_t EventStream_subscribe(Socket_T S, const char *lastEventId);
+
+
+/**
+ * Post a service state change record
+ * @param S The service
+ * @param E The event which changed the state
+ */
+void EventStream_postState(Service_T S, Event_T E);
+
+
+/**
+ * Post a record of the action executed for the event
+ * @param S The service
+ * @param E The event which triggered the action
+ * @param A The action
+ */
+void EventStream_postAction(Service_T S, Event_T E, Action_Type A);
+
+
+#endif
@@ -68,9 +68,22 @@
 #include <limits.h>
 #endif
 
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
 #include "monit.h"
 #include "processor.h"
 #include "base64.h"
+#include "sha1.h"
 
 // libmonit
 #include "util/Str.h"
@@ -100,30 +113,70 @@
  */
 
 
+#define CREDENTIAL_CACHE_SIZE 16
+#define CREDENTIAL_CACHE_TTL  60000 // ms
+#define CREDENTIAL_KEY_SIZE   64    // SHA1 block size
+
+
 static int _httpPostLimit;
 
 
+static const char *_knownHeaders[Header_Count] = {
+        [Header_Authorization]  = "Authorization",
+        [Header_Cookie]         = "Cookie",
+        [Header_ContentLength]  = "Content-Length",
+        [Header_AcceptEncoding] = "Accept-Encoding",
+        [Header_LastEventId]    = "Last-Event-ID"
+};
+
+
+/**
+ * Cache of recently verified basic authentication credentials, so
+ * md5_crypt, crypt or PAM is not consulted on every request. Only
+ * the HMAC of the user and password is stored, keyed with a random
+ * secret which is renewed whenever the cache is flushed
+ */
+static struct {
+        boolean_t initialized;
+        int next;
+        unsigned char key[CREDENTIAL_KEY_SIZE];
+        struct {
+                long long expire;
+                unsigned char digest[SHA1_DIGEST_SIZE];
+        } entry[CREDENTIAL_CACHE_SIZE];
+} _credentials;
+
+
 /* -------------------------------------------------------------- Prototypes */
 
 
-static void do_service(Socket_T);
+static boolean_t do_service(Socket_T);
 static void destroy_entry(void *);
-static char *get_date(char *, int);
+static const char *get_date();
 static char *get_server(char *, int);
-static void create_headers(HttpRequest);
+static boolean_t read_request(HttpRequest);
+static char *next_word(char **);
+static void create_headers(HttpRequest, char *);
 static void send_response(HttpRequest, HttpResponse);
+static boolean_t can_compress(HttpRequest);
+static int format_head(HttpResponse, char *, int, long long);
+static void send_head(HttpResponse, char *, int);
+static void write_chunk(HttpResponse, const void *, size_t);
+static void stream_body(HttpResponse, boolean_t);
 static boolean_t basic_authenticate(HttpRequest);
 static void done(HttpRequest, HttpResponse);
 static void destroy_HttpRequest(HttpRequest);
 static void reset_response(HttpResponse res);
-static HttpParameter parse_parameters(char *);
+static HttpParameter parse_parameters(HttpRequest, char *);
 static boolean_t create_parameters(HttpRequest req);
 static void destroy_HttpResponse(HttpResponse);
 static HttpRequest create_HttpRequest(Socket_T);
 static void internal_error(Socket_T, int, char *);
 static HttpResponse create_HttpResponse(Socket_T);
 static boolean_t is_authenticated(HttpRequest, HttpResponse);
-static int get_next_token(char *s, int *cursor, char **r);
+static void credentials_digest(const char *, const char *, unsigned char [SHA1_DIGEST_SIZE]);
+static boolean_t credentials_cached(const unsigned char [SHA1_DIGEST_SIZE]);
+static void credentials_cache(const unsigned char [SHA1_DIGEST_SIZE]);
 
 
 /*
@@ -149,8 +202,8 @@ struct  ServiceImpl {
 void *http_processor(Socket_T s) {
         if (! Net_canRead(Socket_getSocket(s), REQUEST_TIMEOUT * 1000))
                 internal_error(s, SC_REQUEST_TIMEOUT, "Time out when handling the Request");
-        else
-                do_service(s);
+        else if (do_service(s))
+                return NULL;
         Socket_free(&s);
         return NULL;
 }
@@ -176,6 +229,22 @@ void Processor_setHttpPostLimit() {
 }
 
 
+void Processor_flushCredentials() {
+        memset(&_credentials, 0, sizeof(_credentials));
+        int fd = open("/dev/urandom", O_RDONLY);
+        if (fd < 0 || read(fd, _credentials.key, sizeof(_credentials.key)) != sizeof(_credentials.key)) {
+                // Fallback if the random device is not available
+                for (int i = 0; i < CREDENTIAL_KEY_SIZE; i += 16) {
+                        MD_T token;
+                        memcpy(_credentials.key + i, Util_getToken(token), 16);
+                }
+        }
+        if (fd >= 0)
+                close(fd);
+        _credentials.initialized = true;
+}
+
+
 void escapeHTML(StringBuffer_T sb, const char *s) {
         for (int i = 0; s[i]; i++) {
                 if (s[i] == '<')
@@ -185,7 +254,7 @@ void escapeHTML(StringBuffer_T sb, const char *s) {
                 else if (s[i] == '&')
                         StringBuffer_append(sb, "&amp;");
                 else
-                        StringBuffer_append(sb, "%c", s[i]);
+                        StringBuffer_appendChar(sb, s[i]);
         }
 }
 
@@ -270,6 +339,54 @@ void set_header(HttpResponse res, const char *name, const char *value, ...) {
 }
 
 
+/**
+ * Allow the response body to be sent incrementally. Once the output
+ * buffer grows beyond RES_STREAM_BUFFER, flush_response() sends the
+ * response head and the buffered body, using chunked transfer encoding
+ * for HTTP/1.1 clients. A response which stays small is sent as usual
+ * with a Content-Length header.
+ * @param req HttpRequest object
+ * @param res HttpResponse object
+ */
+void set_streaming(HttpRequest req, HttpResponse res) {
+        res->is_streaming = true;
+        if (IS(req->protocol, "1.1")) {
+                res->protocol = "HTTP/1.1";
+                res->is_chunked = true;
+        }
+        res->is_compressed = can_compress(req);
+}
+
+
+/**
+ * Send the buffered body of a streaming response if the output buffer
+ * exceeds RES_STREAM_BUFFER. Headers must be set before the first call
+ * which sends data, later changes to headers and status are ignored.
+ * For other responses this function does nothing.
+ * @param res HttpResponse object
+ */
+void flush_response(HttpResponse res) {
+        if (res->is_streaming && StringBuffer_length(res->outputbuffer) >= RES_STREAM_BUFFER) {
+                if (! res->is_committed) {
+#ifdef HAVE_LIBZ
+                        if (res->is_compressed) {
+                                z_stream *zstream = CALLOC(1, sizeof(z_stream));
+                                if (deflateInit2(zstream, 6, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+                                        res->zstream = zstream;
+                                        set_header(res, "Content-Encoding", "gzip");
+                                } else {
+                                        FREE(zstream);
+                                }
+                        }
+#endif
+                        char head[RES_STRLEN];
+                        send_head(res, head, format_head(res, head, sizeof(head), -1));
+                }
+                stream_body(res, false);
+        }
+}
+
+
 /**
  * Sets the status code for the response
  * @param res HttpResponse object
@@ -300,13 +417,26 @@ void set_content_type(HttpResponse res, const char *mime) {
  * @return The value of the specified header, NULL if not found
  */
 const char *get_header(HttpRequest req, const char *name) {
-        for (HttpHeader p = req->headers; p; p = p->next)
-                if (IS(p->name, name))
-                        return (p->value);
+        // Search backwards, so the last occurrence of a repeated header wins
+        for (int i = req->header_count - 1; i >= 0; i--)
+                if (IS(req->buffer + req->headers[i].name, name))
+                        return req->buffer + req->headers[i].value;
         return NULL;
 }
 
 
+/**
+ * Returns the value of a well-known header
+ * @param req HttpRequest object
+ * @param header The header to lookup the value for
+ * @return The value of the header, NULL if not found
+ */
+const char *get_known_header(HttpRequest req, Header_Type header) {
+        ASSERT(header >= 0 && header < Header_Count);
+        return req->known[header] ? req->buffer + req->known[header] : NULL;
+}
+
+
 /**
  * Returns the value of the specified parameter
  * @param req HttpRequest object
@@ -438,8 +568,11 @@ const char *get_status_string(int status) {
 /**
  * Receives standard HTTP requests from a client socket and dispatches
  * them to the doXXX methods defined in a cervlet module.
+ * @return true if the connection was handed over by the cervlet (e.g.
+ * to the event stream) and must not be closed, otherwise false
  */
-static void do_service(Socket_T s) {
+static boolean_t do_service(Socket_T s) {
+        boolean_t detached = false;
         volatile HttpResponse res = create_HttpResponse(s);
         volatile HttpRequest req = create_HttpRequest(s);
         if (res && req) {
@@ -455,20 +588,27 @@ static void do_service(Socket_T s) {
                                 send_error(req, res, SC_NOT_IMPLEMENTED, "Method not implemented");
                 }
                 send_response(req, res);
+                detached = res->is_detached;
         }
         done(req, res);
+        return detached;
 }
 
 
 /**
- * Return a (RFC1123) Date string
+ * Return a (RFC1123) Date string. The string is formatted at most once
+ * per second
  */
-static char *get_date(char *result, int size) {
-        time_t now;
-        time(&now);
-        if (strftime(result, size, DATEFMT, gmtime(&now)) <= 0)
-                *result = 0;
-        return result;
+static const char *get_date() {
+        static time_t cached = 0;
+        static char date[STRLEN] = {};
+        time_t now = Time_now();
+        if (now != cached) {
+                if (strftime(date, sizeof(date), DATEFMT, gmtime(&now)) <= 0)
+                        *date = 0;
+                cached = now;
+        }
+        return date;
 }
 
 
@@ -482,24 +622,114 @@ static char *get_server(char *result, int size) {
 
 
 /**
- * Send the response to the client. If the response has already been
- * commited, this function does nothing.
+ * Return true if the client accepts a gzip compressed response
  */
-static void send_response(HttpRequest req, HttpResponse res) {
-        Socket_T S = res->S;
-
-        if (! res->is_committed) {
-                char date[STRLEN];
-                char server[STRLEN];
+static boolean_t can_compress(HttpRequest req) {
 #ifdef HAVE_LIBZ
-                const char *acceptEncoding = get_header(req, "Accept-Encoding");
-                boolean_t canCompress = acceptEncoding && Str_sub(acceptEncoding, "gzip") ? true : false;
+        const char *acceptEncoding = get_known_header(req, Header_AcceptEncoding);
+        return acceptEncoding && Str_sub(acceptEncoding, "gzip") ? true : false;
 #else
-                boolean_t canCompress = false;
+        return false;
 #endif
+}
+
+
+/**
+ * Format the status line and the fixed headers. A negative content
+ * length marks a streamed body
+ */
+static int format_head(HttpResponse res, char *head, int size, long long contentLength) {
+        char server[STRLEN];
+        int length = snprintf(head, size,
+                              "%s %d %s\r\n"
+                              "Date: %s\r\n"
+                              "Server: %s\r\n",
+                              res->protocol, res->status, res->status_msg, get_date(), get_server(server, STRLEN));
+        if (contentLength >= 0)
+                length += snprintf(head + length, size - length, "Content-Length: %lld\r\n", contentLength);
+        else if (res->is_chunked)
+                length += snprintf(head + length, size - length, "Transfer-Encoding: chunked\r\n");
+        length += snprintf(head + length, size - length, "Connection: close\r\n");
+        return length;
+}
+
+
+/**
+ * Commit the response and send the head
+ */
+static void send_head(HttpResponse res, char *head, int headLength) {
+        char *headers = get_headers(res);
+        res->is_committed = true;
+        struct iovec iov[] = {
+                {.iov_base = head, .iov_len = headLength},
+                {.iov_base = headers, .iov_len = headers ? strlen(headers) : 0},
+                {.iov_base = "\r\n", .iov_len = 2}
+        };
+        Socket_writev(res->S, iov, sizeof(iov) / sizeof(iov[0]));
+        FREE(headers);
+}
+
+
+/**
+ * Send data of a streamed body, as one chunk if chunked transfer
+ * encoding is used
+ */
+static void write_chunk(HttpResponse res, const void *data, size_t length) {
+        if (length) {
+                if (res->is_chunked) {
+                        char size[32];
+                        struct iovec iov[] = {
+                                {.iov_base = size, .iov_len = snprintf(size, sizeof(size), "%zx\r\n", length)},
+                                {.iov_base = (void *)data, .iov_len = length},
+                                {.iov_base = "\r\n", .iov_len = 2}
+                        };
+                        Socket_writev(res->S, iov, sizeof(iov) / sizeof(iov[0]));
+                } else {
+                        Socket_write(res->S, (void *)data, length);
+                }
+        }
+}
+
+
+/**
+ * Send the output buffer as part of the streamed body and clear it. If
+ * finish is true the body is completed
+ */
+static void stream_body(HttpResponse res, boolean_t finish) {
+        const void *data = StringBuffer_toString(res->outputbuffer);
+        size_t length = StringBuffer_length(res->outputbuffer);
+#ifdef HAVE_LIBZ
+        z_stream *zstream = res->zstream;
+        if (zstream) {
+                unsigned char out[RES_STREAM_BUFFER];
+                zstream->next_in = (unsigned char *)data;
+                zstream->avail_in = (unsigned int)length;
+                do {
+                        zstream->next_out = out;
+                        zstream->avail_out = sizeof(out);
+                        deflate(zstream, finish ? Z_FINISH : Z_NO_FLUSH);
+                        write_chunk(res, out, sizeof(out) - zstream->avail_out);
+                } while (zstream->avail_out == 0);
+        } else
+#endif
+        {
+                write_chunk(res, data, length);
+        }
+        StringBuffer_clear(res->outputbuffer);
+        if (finish && res->is_chunked)
+                Socket_write(res->S, "0\r\n\r\n", 5);
+}
+
+
+/**
+ * Send the response to the client. If the response has already been
+ * commited, only the rest of a streamed body is sent.
+ */
+static void send_response(HttpRequest req, HttpResponse res) {
+        if (! res->is_committed) {
                 const void *body = NULL;
                 size_t bodyLength = 0;
-                if (canCompress && StringBuffer_length(res->outputbuffer) > 0) {
+                if (can_compress(req) && StringBuffer_length(res->outputbuffer) > 0) {
                         body = StringBuffer_toCompressed(res->outputbuffer, 6, &bodyLength);
                         set_header(res, "Content-Encoding", "gzip");
                 } else {
@@ -508,19 +738,18 @@ static void send_response(HttpRequest req, HttpResponse res) {
                 }
                 char *headers = get_headers(res);
                 res->is_committed = true;
-                get_date(date, STRLEN);
-                get_server(server, STRLEN);
-                Socket_print(S, "%s %d %s\r\n", res->protocol, res->status, res->status_msg);
-                Socket_print(S, "Date: %s\r\n", date);
-                Socket_print(S, "Server: %s\r\n", server);
-                Socket_print(S, "Content-Length: %zu\r\n", bodyLength);
-                Socket_print(S, "Connection: close\r\n");
-                if (headers)
-                        Socket_print(S, "%s", headers);
-                Socket_print(S, "\r\n");
-                if (bodyLength)
-                        Socket_write(S, (unsigned char *)body, bodyLength);
+                // Assemble the response head once and send it together with the body in one gather write
+                char head[RES_STRLEN];
+                struct iovec iov[] = {
+                        {.iov_base = head, .iov_len = format_head(res, head, sizeof(head), bodyLength)},
+                        {.iov_base = headers, .iov_len = headers ? strlen(headers) : 0},
+                        {.iov_base = "\r\n", .iov_len = 2},
+                        {.iov_base = (void *)body, .iov_len = bodyLength}
+                };
+                Socket_writev(res->S, iov, sizeof(iov) / sizeof(iov[0]));
                 FREE(headers);
+        } else if (res->is_streaming) {
+                stream_body(res, true);
         }
 }
 
@@ -529,34 +758,42 @@ static void send_response(HttpRequest req, HttpResponse res) {
 
 
 /**
- * Returns a new HttpRequest object wrapping the client request
+ * Returns a new HttpRequest object wrapping the client request. The
+ * request line and headers are read into one buffer and parsed in
+ * place, all request memory is allocated from the request arena
  */
 static HttpRequest create_HttpRequest(Socket_T S) {
-        char line[REQ_STRLEN];
-        if (Socket_readLine(S, line, sizeof(line)) == NULL) {
+        Arena_T arena = Arena_new(REQ_ARENA_SIZE);
+        HttpRequest req = NULL;
+        ARENA_NEW(arena, req);
+        req->S = S;
+        req->arena = arena;
+        if (! read_request(req)) {
+                destroy_HttpRequest(req);
                 internal_error(S, SC_BAD_REQUEST, "No request found");
                 return NULL;
         }
+        char *line = req->buffer;
+        char *headers = strchr(line, '\n');
+        if (headers)
+                *headers++ = 0;
         Str_chomp(line);
-        char method[STRLEN];
-        char url[REQ_STRLEN];
-        char protocol[STRLEN];
-        if (sscanf(line, "%255s %1023s HTTP/%3[1.0]", method, url, protocol) != 3) {
+        req->method = next_word(&line);
+        req->url = next_word(&line);
+        char *version = next_word(&line);
+        if (! (req->method && req->url && version && Str_startsWith(version, "HTTP/") && *(req->protocol = version + 5) && strlen(req->protocol) <= 3 && strspn(req->protocol, "1.0") == strlen(req->protocol))) {
+                destroy_HttpRequest(req);
                 internal_error(S, SC_BAD_REQUEST, "Cannot parse request");
                 return NULL;
         }
-        if (strlen(url) >= MAX_URL_LENGTH) {
+        if (strlen(req->url) >= MAX_URL_LENGTH) {
+                destroy_HttpRequest(req);
                 internal_error(S, SC_BAD_REQUEST, "[error] URL too long");
                 return NULL;
         }
-        HttpRequest req = NULL;
-        NEW(req);
-        req->S = S;
-        Util_urlDecode(url);
-        req->url = Str_dup(url);
-        req->method = Str_dup(method);
-        req->protocol = Str_dup(protocol);
-        create_headers(req);
+        Util_urlDecode(req->url);
+        if (headers)
+                create_headers(req, headers);
         if (! create_parameters(req)) {
                 destroy_HttpRequest(req);
                 internal_error(S, SC_BAD_REQUEST, "Cannot parse Request parameters");
@@ -575,8 +812,9 @@ static HttpResponse create_HttpResponse(Socket_T S) {
         NEW(res);
         res->S = S;
         res->status = SC_OK;
-        res->outputbuffer = StringBuffer_create(256);
+        res->outputbuffer = StringBuffer_borrow(256);
         res->is_committed = false;
+        res->is_detached = false;
         res->protocol = SERVER_PROTOCOL;
         res->status_msg = get_status_string(SC_OK);
         Util_getToken(res->token);
@@ -585,23 +823,69 @@ static HttpResponse create_HttpResponse(Socket_T S) {
 
 
 /**
- * Create HTTP headers for the given request
+ * Read the request line and headers up to the empty line into the
+ * request buffer. Returns false if nothing was read or the headers
+ * exceed REQ_HEADER_LIMIT
  */
-static void create_headers(HttpRequest req) {
-        char line[REQ_STRLEN] = {0};
-        while (Socket_readLine(req->S, line, sizeof(line)) && ! (Str_isEqual(line, "\r\n") || Str_isEqual(line, "\n"))) {
+static boolean_t read_request(HttpRequest req) {
+        int length = 0;
+        req->buffer = Arena_alloc(req->arena, REQ_HEADER_LIMIT, __func__, __FILE__, __LINE__);
+        *req->buffer = 0;
+        for (char *line = req->buffer; Socket_readLine(req->S, line, REQ_HEADER_LIMIT - length); line = req->buffer + length) {
+                int n = (int)strlen(line);
+                length += n;
+                if (line[n - 1] != '\n')
+                        return length < REQ_HEADER_LIMIT - 1; // End of input, or the buffer is full
+                if (length > n && (IS(line, "\r\n") || IS(line, "\n")))
+                        break; // End of headers
+        }
+        return length > 0 && length < REQ_HEADER_LIMIT - 1;
+}
+
+
+/**
+ * Return the next space separated word of s and advance s past it, or
+ * NULL if there are no more words
+ */
+static char *next_word(char **s) {
+        char *word = *s + strspn(*s, " \t");
+        if (! *word)
+                return NULL;
+        char *end = word + strcspn(word, " \t");
+        if (*end)
+                *end++ = 0;
+        *s = end;
+        return word;
+}
+
+
+/**
+ * Create HTTP headers for the given request. The header lines are
+ * split in place and stored as offsets into the request buffer
+ */
+static void create_headers(HttpRequest req, char *headers) {
+        for (char *line = headers, *next; line && *line; line = next) {
+                if ((next = strchr(line, '\n')))
+                        *next++ = 0;
                 char *value = strchr(line, ':');
                 if (value) {
-                        HttpHeader header = NULL;
-                        NEW(header);
                         *value++ = 0;
-                        Str_trim(line);
-                        Str_trim(value);
-                        Str_chomp(value);
-                        header->name = Str_dup(line);
-                        header->value = Str_dup(value);
-                        header->next = req->headers;
-                        req->headers = header;
+                        char *name = Str_trim(line);
+                        value = Str_trim(Str_chomp(value));
+                        if (*name) {
+                                unsigned short v = (unsigned short)(value - req->buffer);
+                                for (int i = 0; i < Header_Count; i++) {
+                                        if (IS(name, _knownHeaders[i])) {
+                                                req->known[i] = v;
+                                                break;
+                                        }
+                                }
+                                if (req->header_count < REQ_HEADERS) {
+                                        req->headers[req->header_count].name = (unsigned short)(name - req->buffer);
+                                        req->headers[req->header_count].value = v;
+                                        req->header_count++;
+                                }
+                        }
                 }
         }
 }
@@ -615,34 +899,28 @@ static boolean_t create_parameters(HttpRequest req) {
         char *query_string = NULL;
         if (IS(req->method, METHOD_POST)) {
                 int len;
-                const char *content_length = get_header(req, "Content-Length");
+                const char *content_length = get_known_header(req, Header_ContentLength);
                 if (! content_length || sscanf(content_length, "%d", &len) != 1 || len < 0 || len > _httpPostLimit)
                         return false;
                 if (len != 0) {
-                        query_string = CALLOC(1, _httpPostLimit + 1);
-                        int n = Socket_read(req->S, query_string, len);
-                        if (n != len) {
-                                FREE(query_string);
+                        query_string = Arena_calloc(req->arena, 1, len + 1, __func__, __FILE__, __LINE__);
+                        if (Socket_read(req->S, query_string, len) != len)
                                 return false;
-                        }
                 }
         } else if (IS(req->method, METHOD_GET)) {
                 char *p = strchr(req->url, '?');
                 if (p) {
                         *p++ = 0;
-                        query_string = Str_dup(p);
+                        query_string = p;
                 }
         }
-        if (query_string) {
-                if (*query_string) {
-                        char *p = strchr(query_string, '/');
-                        if (p) {
-                                *p++ = 0;
-                                req->pathinfo = Str_dup(p);
-                        }
-                        req->params = parse_parameters(query_string);
+        if (query_string && *query_string) {
+                char *p = strchr(query_string, '/');
+                if (p) {
+                        *p++ = 0;
+                        req->pathinfo = p;
                 }
-                FREE(query_string);
+                req->params = parse_parameters(req, query_string);
         }
         return true;
 }
@@ -677,16 +955,8 @@ static void done(HttpRequest req, HttpResponse res) {
  */
 static void destroy_HttpRequest(HttpRequest req) {
         if (req) {
-                FREE(req->method);
-                FREE(req->url);
-                FREE(req->pathinfo);
-                FREE(req->protocol);
-                FREE(req->remote_user);
-                if (req->headers)
-                        destroy_entry(req->headers);
-                if (req->params)
-                        destroy_entry(req->params);
-                FREE(req);
+                Arena_T arena = req->arena;
+                Arena_free(&arena);
         }
 }
 
@@ -696,7 +966,13 @@ static void destroy_HttpRequest(HttpRequest req) {
  */
 static void destroy_HttpResponse(HttpResponse res) {
         if (res) {
-                StringBuffer_free(&(res->outputbuffer));
+#ifdef HAVE_LIBZ
+                if (res->zstream) {
+                        deflateEnd(res->zstream);
+                        FREE(res->zstream);
+                }
+#endif
+                StringBuffer_release(&(res->outputbuffer));
                 if (res->headers)
                         destroy_entry(res->headers);
                 FREE(res);
@@ -743,7 +1019,7 @@ static boolean_t is_authenticated(HttpRequest req, HttpResponse res) {
                         send_error(req, res, SC_FORBIDDEN, "Invalid CSRF Token");
                         return false;
                 }
-                const char *cookie = get_header(req, "Cookie");
+                const char *cookie = get_known_header(req, Header_Cookie);
                 if (! cookie) {
                         LogError("HttpRequest: access denied -- client [%s]: missing CSRF token cookie\n", NVLSTR(Socket_getRemoteHost(req->S)));
                         send_error(req, res, SC_FORBIDDEN, "Invalid CSRF Token");
@@ -795,7 +1071,7 @@ static boolean_t is_authenticated(HttpRequest req, HttpResponse res) {
  * the user.
  */
 static boolean_t basic_authenticate(HttpRequest req) {
-        const char *credentials = get_header(req, "Authorization");
+        const char *credentials = get_known_header(req, Header_Authorization);
         if (! (credentials && Str_startsWith(credentials, "Basic "))) {
                 LogDebug("HttpRequest: access denied -- client [%s]: missing or invalid Authorization header\n", NVLSTR(Socket_getRemoteHost(req->S)));
                 return false;
@@ -822,16 +1098,76 @@ static boolean_t basic_authenticate(HttpRequest req) {
                 LogError("HttpRequest: access denied -- client [%s]: unknown user '%s'\n", NVLSTR(Socket_getRemoteHost(req->S)), uname);
                 return false;
         }
-        /* Check if user has supplied the right password */
-        if (! Util_checkCredentials(uname,  password)) {
-                LogError("HttpRequest: access denied -- client [%s]: wrong password for user '%s'\n", NVLSTR(Socket_getRemoteHost(req->S)), uname);
-                return false;
+        /* Check if user has supplied the right password, unless the same credentials were verified recently */
+        unsigned char digest[SHA1_DIGEST_SIZE];
+        credentials_digest(uname, password, digest);
+        if (credentials_cached(digest)) {
+                Run.timing.credentialhits++;
+        } else {
+                Run.timing.credentialmisses++;
+                if (! Util_checkCredentials(uname,  password)) {
+                        LogError("HttpRequest: access denied -- client [%s]: wrong password for user '%s'\n", NVLSTR(Socket_getRemoteHost(req->S)), uname);
+                        return false;
+                }
+                credentials_cache(digest);
         }
-        req->remote_user = Str_dup(uname);
+        req->remote_user = strcpy(Arena_alloc(req->arena, strlen(uname) + 1, __func__, __FILE__, __LINE__), uname);
         return true;
 }
 
 
+/**
+ * Compute HMAC-SHA1 of the user and password with the cache secret
+ */
+static void credentials_digest(const char *uname, const char *password, unsigned char digest[SHA1_DIGEST_SIZE]) {
+        if (! _credentials.initialized)
+                Processor_flushCredentials();
+        unsigned char pad[CREDENTIAL_KEY_SIZE];
+        sha1_context_t ctx;
+        for (int i = 0; i < CREDENTIAL_KEY_SIZE; i++)
+                pad[i] = _credentials.key[i] ^ 0x36;
+        sha1_init(&ctx);
+        sha1_append(&ctx, pad, sizeof(pad));
+        sha1_append(&ctx, (const unsigned char *)uname, strlen(uname) + 1); // Include the terminating zero as separator
+        sha1_append(&ctx, (const unsigned char *)password, strlen(password));
+        sha1_finish(&ctx, digest);
+        for (int i = 0; i < CREDENTIAL_KEY_SIZE; i++)
+                pad[i] = _credentials.key[i] ^ 0x5c;
+        sha1_init(&ctx);
+        sha1_append(&ctx, pad, sizeof(pad));
+        sha1_append(&ctx, digest, SHA1_DIGEST_SIZE);
+        sha1_finish(&ctx, digest);
+}
+
+
+/**
+ * Return true if the digest matches an unexpired cache entry. Every
+ * entry is compared in constant time
+ */
+static boolean_t credentials_cached(const unsigned char digest[SHA1_DIGEST_SIZE]) {
+        boolean_t found = false;
+        long long now = Time_monotonic();
+        for (int i = 0; i < CREDENTIAL_CACHE_SIZE; i++) {
+                unsigned char diff = 0;
+                for (int j = 0; j < SHA1_DIGEST_SIZE; j++)
+                        diff |= _credentials.entry[i].digest[j] ^ digest[j];
+                if (diff == 0 && _credentials.entry[i].expire > now)
+                        found = true;
+        }
+        return found;
+}
+
+
+/**
+ * Store a successfully verified digest, replacing the oldest entry
+ */
+static void credentials_cache(const unsigned char digest[SHA1_DIGEST_SIZE]) {
+        memcpy(_credentials.entry[_credentials.next].digest, digest, SHA1_DIGEST_SIZE);
+        _credentials.entry[_credentials.next].expire = Time_monotonic() + CREDENTIAL_CACHE_TTL;
+        _credentials.next = (_credentials.next + 1) % CREDENTIAL_CACHE_SIZE;
+}
+
+
 /* --------------------------------------------------------------- Utilities */
 
 
@@ -841,11 +1177,9 @@ static boolean_t basic_authenticate(HttpRequest req) {
  * properly; i.e. with a valid HttpRequest and a valid HttpResponse.
  */
 static void internal_error(Socket_T S, int status, char *msg) {
-        char date[STRLEN];
         char server[STRLEN];
         const char *status_msg = get_status_string(status);
 
-        get_date(date, STRLEN);
         get_server(server, STRLEN);
         Socket_print(S,
                      "%s %d %s\r\n"
@@ -858,74 +1192,32 @@ static void internal_error(Socket_T S, int status, char *msg) {
                      "<body bgcolor=#FFFFFF><h2>%s</h2>%s<p>"
                      "<hr><a href='%s'><font size=-1>%s</font></a>"
                      "</body></html>\r\n",
-                     SERVER_PROTOCOL, status, status_msg, date, server,
+                     SERVER_PROTOCOL, status, status_msg, get_date(), server,
                      status_msg, status_msg, msg, SERVER_URL, server);
         DEBUG("HttpRequest: error -- client [%s]: %s %d %s\n", NVLSTR(Socket_getRemoteHost(S)), SERVER_PROTOCOL, status, msg ? msg : status_msg);
 }
 
 
 /**
- * Parse request parameters from the given query string and return a
- * linked list of HttpParameters
+ * Parse request parameters from the given query string in place and
+ * return a linked list of HttpParameters allocated from the request arena
  */
-static HttpParameter parse_parameters(char *query_string) {
-#define KEY 1
-#define VALUE 2
-        int token;
-        int cursor = 0;
-        char *key = NULL;
-        char *value = NULL;
+static HttpParameter parse_parameters(HttpRequest req, char *query_string) {
         HttpParameter head = NULL;
-
-        while ((token = get_next_token(query_string, &cursor, &value))) {
-                if (token == KEY)
-                        key = value;
-                else if (token == VALUE) {
+        for (char *token = query_string, *next; token && *token; token = next) {
+                if ((next = strchr(token, '&')))
+                        *next++ = 0;
+                char *value = strchr(token, '=');
+                if (value && value != token) {
                         HttpParameter p = NULL;
-                        if (! key)
-                                goto error;
-                        NEW(p);
-                        p->name = key;
+                        *value++ = 0;
+                        ARENA_NEW(req->arena, p);
+                        p->name = token;
                         p->value = Util_urlDecode(value);
                         p->next = head;
                         head = p;
-                        key = NULL;
                 }
         }
         return head;
-error:
-        FREE(key);
-        FREE(value);
-        if ( head != NULL )
-                destroy_entry(head);
-        return NULL;
-}
-
-
-/**
- * A mini-scanner for tokenizing a query string
- */
-static int get_next_token(char *s, int *cursor, char **r) {
-        int i = *cursor;
-
-        while (s[*cursor]) {
-                if (s[*cursor+1] == '=') {
-                        *cursor += 1;
-                        *r = Str_ndup(&s[i], (*cursor-i));
-                        return KEY;
-                }
-                if (s[*cursor] == '=') {
-                        while (s[*cursor] && s[*cursor] != '&') *cursor += 1;
-                        if (s[*cursor] == '&') {
-                                *r = Str_ndup(&s[i+1], (*cursor-i)-1);
-                                *cursor += 1;
-                        }  else {
-                                *r = Str_ndup(&s[i+1], (*cursor-i));
-                        }
-                        return VALUE;
-                }
-                *cursor += 1;
-        }
-        return 0;
 }
 
@@ -34,6 +34,9 @@
 #include "socket.h"
 #include "httpstatus.h"
 
+// libmonit
+#include "util/Arena.h"
+
 /* Server masquerade */
 #define SERVER_NAME        "monit"
 #define SERVER_VERSION     VERSION
@@ -52,6 +55,14 @@
 #define RES_STRLEN         2048
 #define MAX_URL_LENGTH     512
 
+/* Request limits */
+#define REQ_HEADER_LIMIT   8192  /* Request line and headers */
+#define REQ_HEADERS        32    /* Headers accessible by name */
+#define REQ_ARENA_SIZE     16384
+
+/* A streamed response body is sent when the output buffer exceeds this size */
+#define RES_STREAM_BUFFER  16384
+
 /* Request timeout in seconds */
 #define REQUEST_TIMEOUT    30
 
@@ -68,6 +79,17 @@ typedef struct entry *HttpHeader;
 typedef struct entry *HttpParameter;
 
 
+/* Well-known request headers, indexed directly */
+typedef enum {
+        Header_Authorization = 0,
+        Header_Cookie,
+        Header_ContentLength,
+        Header_AcceptEncoding,
+        Header_LastEventId,
+        Header_Count  /* Must be last */
+} Header_Type;
+
+
 typedef struct request {
         char *url;
         Socket_T S;
@@ -75,8 +97,15 @@ typedef struct request {
         char *protocol;
         char *pathinfo;
         char *remote_user;
-        HttpHeader headers;
+        char *buffer;                        /**< Request line and headers, parsed in place */
+        int header_count;
+        struct {
+                unsigned short name;
+                unsigned short value;
+        } headers[REQ_HEADERS];              /**< Header offsets in the buffer */
+        unsigned short known[Header_Count];  /**< Value offsets of well-known headers, 0 if not present */
         HttpParameter params;
+        Arena_T arena;                       /**< Request memory, released in one go */
         Ssl_T ssl;
 } *HttpRequest;
 
@@ -86,6 +115,11 @@ typedef struct response {
         Socket_T S;
         const char *protocol;
         boolean_t is_committed;
+        boolean_t is_detached;           /**< The connection was handed over, keep it open */
+        boolean_t is_streaming;          /**< The body may be sent incrementally by flush_response() */
+        boolean_t is_chunked;            /**< Use chunked transfer encoding for the streamed body */
+        boolean_t is_compressed;         /**< Compress the streamed body */
+        void *zstream;                   /**< Deflate state of the streamed body */
         HttpHeader headers;
         const char *status_msg;
         StringBuffer_T outputbuffer;
@@ -102,10 +136,14 @@ const char *get_status_string(int status_code);
 void add_Impl(void(*doGet)(HttpRequest, HttpResponse), void(*doPost)(HttpRequest, HttpResponse));
 void set_content_type(HttpResponse res, const char *mime);
 const char *get_header(HttpRequest req, const char *header_name);
+const char *get_known_header(HttpRequest req, Header_Type header);
 void escapeHTML(StringBuffer_T sb, const char *s);
 void send_error(HttpRequest, HttpResponse, int status, const char *message, ...) __attribute__((format (printf, 4, 5)));
 const char *get_parameter(HttpRequest req, const char *parameter_name);
 void set_header(HttpResponse res, const char *name, const char *value, ...) __attribute__((format (printf, 3, 4)));
+void set_streaming(HttpRequest req, HttpResponse res);
+void flush_response(HttpResponse res);
 void Processor_setHttpPostLimit();
+void Processor_flushCredentials();
 
 #endif
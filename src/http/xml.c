@@ -78,11 +78,28 @@ static void _escapeCDATA(StringBuffer_T B, const char *buf) {
                 if (buf[i] == '>' && i > 1 && (buf[i - 1] == ']' && buf[i - 2] == ']'))
                         StringBuffer_append(B, "&gt;");
                 else
-                        StringBuffer_append(B, "%c", buf[i]);
+                        StringBuffer_appendChar(B, buf[i]);
         }
 }
 
 
+static void _timing(StringBuffer_T B, const char *name, Timing_T *timing) {
+        StringBuffer_append(B,
+                "<%s>"
+                "<count>%llu</count>"
+                "<last>%llu</last>"     // microseconds
+                "<average>%llu</average>" // microseconds
+                "<max>%llu</max>"       // microseconds
+                "</%s>",
+                name,
+                timing->count,
+                timing->last,
+                timing->count ? timing->total / timing->count : 0ULL,
+                timing->max,
+                name);
+}
+
+
 /**
  * Prints a document header into the given buffer.
  * @param B StringBuffer object
@@ -125,6 +142,14 @@ static void document_head(StringBuffer_T B, int V, const char *myip) {
                         StringBuffer_append(B, "<credentials><username>%s</username><password>%s</password></credentials>", Run.mmonitcredentials->uname, Run.mmonitcredentials->passwd);
         }
 
+        StringBuffer_append(B, "<timing>");
+        _timing(B, "cycle", &Run.timing.cycle);
+        _timing(B, "events", &Run.timing.events);
+        _timing(B, "system", &Run.timing.system);
+        _timing(B, "processes", &Run.timing.processes);
+        _timing(B, "state", &Run.timing.state);
+        StringBuffer_append(B, "<overruns>%llu</overruns><stalls>%llu</stalls></timing>", Run.timing.overruns, Run.timing.stalls);
+
         StringBuffer_append(B,
                             "</server>"
                             "<platform>"
@@ -211,10 +236,14 @@ static void status_service(Service_T S, StringBuffer_T B, int V) {
                 StringBuffer_append(B, "<every><type>%d</type>", S->every.type);
                 if (S->every.type == 1)
                         StringBuffer_append(B, "<counter>%d</counter><number>%d</number>", S->every.spec.cycle.counter, S->every.spec.cycle.number);
+                else if (S->every.type == Every_Interval)
+                        StringBuffer_append(B, "<interval>%d</interval><max>%d</max><current>%d</current>", S->every.spec.interval.base, S->every.spec.interval.max, S->every.spec.interval.current);
                 else
                         StringBuffer_append(B, "<cron>%s</cron>", S->every.spec.cron);
                 StringBuffer_append(B, "</every>");
         }
+        if (S->timing.count)
+                _timing(B, "checktime", &S->timing);
         if (Util_hasServiceStatus(S)) {
                 switch (S->type) {
                         case Service_File:
@@ -480,6 +509,11 @@ static void status_service(Service_T S, StringBuffer_T B, int V) {
 #ifdef HAVE_CPU_WAIT
                                             "<wait>%.1f</wait>"
 #endif
+#ifdef HAVE_CPU_STEAL
+                                            "<steal>%.1f</steal>"
+                                            "<guest>%.1f</guest>"
+#endif
+                                            "<coremax>%.1f</coremax>"
                                             "</cpu>"
                                             "<memory>"
                                             "<percent>%.1f</percent>"
@@ -498,6 +532,11 @@ static void status_service(Service_T S, StringBuffer_T B, int V) {
 #ifdef HAVE_CPU_WAIT
                                             systeminfo.cpu.usage.wait > 0. ? systeminfo.cpu.usage.wait : 0.,
 #endif
+#ifdef HAVE_CPU_STEAL
+                                            systeminfo.cpu.usage.steal > 0. ? systeminfo.cpu.usage.steal : 0.,
+                                            systeminfo.cpu.usage.guest > 0. ? systeminfo.cpu.usage.guest : 0.,
+#endif
+                                            systeminfo.cpu.core.max > 0. ? systeminfo.cpu.core.max : 0.,
                                             systeminfo.memory.usage.percent,
                                             (unsigned long long)((double)systeminfo.memory.usage.bytes / 1024.),               // Send as kB for backward compatibility
                                             systeminfo.swap.usage.percent,
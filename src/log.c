@@ -68,10 +68,25 @@
 #include <sys/stat.h>
 #endif
 
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+
 #include "monit.h"
+#include "event.h"
+#include "syslogger.h"
 
 // libmonit
 #include "system/Time.h"
+#include "exceptions/AssertException.h"
 
 
 /**
@@ -79,6 +94,13 @@
  *  with a preceding timestamp. Methods support both syslog or own
  *  logfile.
  *
+ *  The daemon starts a log writer thread with log_start(). The logging
+ *  threads then only format the message into a slot of a lock-free ring
+ *  buffer and the writer thread writes the records in batches with
+ *  writev(2). If the ring is full, the message is dropped and counted.
+ *  Critical and more severe messages are written synchronously as they
+ *  may precede an abort.
+ *
  *  @file
  */
 
@@ -86,8 +108,54 @@
 /* ------------------------------------------------------------- Definitions */
 
 
+#define LOG_RING_SIZE   256 // Number of records in the ring buffer, must be a power of two
+#define LOG_RECORD_SIZE 512 // Messages up to this size are stored in the record itself
+#define LOG_WAIT        100 // Maximum time [ms] the writer thread sleeps if the ring is empty
+#if defined IOV_MAX && IOV_MAX < 130
+#define LOG_BATCH       (IOV_MAX / 2 - 1)
+#else
+#define LOG_BATCH       64  // Maximum number of records written by one writev(2)
+#endif
+
+
+/**
+ * A log line under construction. The line is built in the caller's buffer and moved to the heap only if it outgrows it
+ */
+typedef struct Line_T {
+        char *buffer;
+        int size;
+        int length;
+        char *initial;
+} Line_T;
+
+
+typedef struct LogRecord_T {
+        unsigned long long sequence;           /**< Ring slot sequence number */
+        int priority;                                  /**< Message priority */
+        int length;                                      /**< Message length */
+        time_t time;                                  /**< Message timestamp */
+        char *message;   /**< The record buffer or a copy of a longer message */
+        char buffer[LOG_RECORD_SIZE];                    /**< Message buffer */
+} *LogRecord_T;
+
+
 static FILE *LOG = NULL;
 static Mutex_T log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct {
+        int running;                  /**< The writer thread accepts records */
+        int producers;        /**< Threads which may access the ring right now */
+        unsigned long long head;       /**< Next ring position for producers */
+        unsigned long long tail;   /**< Next position to write, writer thread only */
+        unsigned long long reported;      /**< Dropped messages already logged */
+        Thread_T thread;
+        Sem_T cond;
+        Mutex_T mutex;                       /**< Serializes the writes to the log */
+        struct {
+                time_t time;
+                char text[STRLEN];
+        } timestamp;                      /**< Formatted timestamp cached per second */
+        LogRecord_T ring;
+} _writer = {};
 
 
 static struct mylogpriority {
@@ -113,6 +181,21 @@ static boolean_t open_log();
 static const char *logPriorityDescription(int p);
 static void log_log(int priority, const char *s, va_list ap);
 static void log_backtrace();
+static void log_write(int priority, const char *s, va_list ap);
+static void log_logf(int priority, const char *s, ...);
+static void _lineInit(Line_T *l, char *buffer, int size);
+static void _lineFree(Line_T *l);
+static void _lineWrite(int priority, Line_T *l);
+static void _syslog(int priority, time_t time, const char *message, int length);
+static void _jsonText(Line_T *l, int priority, time_t time, const char *text, int length);
+static void _jsonEvent(Line_T *l, int priority, time_t time, Service_T S, Event_T E);
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+static boolean_t _enter();
+static void _leave();
+static int _writeBatch();
+static void *_writerThread(void *args);
+static void _pushEvent(int priority, Service_T S, Event_T E);
+#endif
 
 
 /* ------------------------------------------------------------------ Public */
@@ -377,10 +460,115 @@ void vLogDebug(const char *s, va_list ap) {
 }
 
 
+/**
+ * Log a service event. With the JSON log format the event is written as
+ * one JSON object with the service, event and metrics fields, otherwise
+ * as the "'service' message" text line
+ * @param priority A message priority
+ * @param S The service
+ * @param E The event
+ */
+void LogEvent(int priority, Service_T S, Event_T E) {
+        ASSERT(S);
+        ASSERT(E);
+        if (! (Run.flags & Run_LogJson)) {
+                log_logf(priority, "'%s' %s\n", S->name, E->message);
+                return;
+        }
+        char buffer[LOG_RECORD_SIZE];
+        Line_T l;
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+        if (_enter()) {
+                if (priority > LOG_CRIT) {
+                        _pushEvent(priority, S, E);
+                } else {
+                        LOCK(_writer.mutex)
+                        {
+                                while (_writeBatch())
+                                        ;
+                                _lineInit(&l, buffer, sizeof(buffer));
+                                _jsonEvent(&l, priority, time(NULL), S, E);
+                                _lineWrite(priority, &l);
+                                _lineFree(&l);
+                        }
+                        END_LOCK;
+                }
+                _leave();
+                return;
+        }
+#endif
+        _lineInit(&l, buffer, sizeof(buffer));
+        _jsonEvent(&l, priority, time(NULL), S, E);
+        _lineWrite(priority, &l);
+        _lineFree(&l);
+}
+
+
+/**
+ * Start the log writer thread and the syslog server client, if set. The
+ * log messages are then written asynchronously. Must be called after the
+ * daemon has forked
+ */
+void log_start() {
+        Syslogger_start();
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+        if (! _writer.running) {
+                // The ring is kept for the process lifetime. log_stop() waited for the producers which saw the writer running, so no thread accesses it now
+                ASSERT(__atomic_load_n(&_writer.producers, __ATOMIC_SEQ_CST) == 0);
+                if (! _writer.ring)
+                        _writer.ring = CALLOC(LOG_RING_SIZE, sizeof(*_writer.ring));
+                for (int i = 0; i < LOG_RING_SIZE; i++)
+                        _writer.ring[i].sequence = i;
+                _writer.head = _writer.tail = 0ULL;
+                _writer.reported = Run.timing.logdropped;
+                _writer.timestamp.time = 0;
+                Mutex_init(_writer.mutex);
+                Sem_init(_writer.cond);
+                __atomic_store_n(&_writer.running, true, __ATOMIC_SEQ_CST);
+                Thread_create(_writer.thread, _writerThread, NULL);
+        }
+#endif
+}
+
+
+/**
+ * Stop the log writer thread and the syslog server client after they have
+ * written the queued messages. The log messages are then written
+ * synchronously again
+ */
+void log_stop() {
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+        if (__atomic_load_n(&_writer.running, __ATOMIC_ACQUIRE)) {
+                LOCK(_writer.mutex)
+                {
+                        __atomic_store_n(&_writer.running, false, __ATOMIC_SEQ_CST);
+                        Sem_signal(_writer.cond);
+                }
+                END_LOCK;
+                Thread_join(_writer.thread);
+                // Wait for the threads which saw the writer running just before it stopped and are still pushing a record
+                while (__atomic_load_n(&_writer.producers, __ATOMIC_SEQ_CST))
+                        Time_usleep(100);
+                LOCK(_writer.mutex)
+                {
+                        // Write the records they pushed
+                        while (_writeBatch())
+                                ;
+                }
+                END_LOCK;
+                Sem_destroy(_writer.cond);
+                Mutex_destroy(_writer.mutex);
+        }
+#endif
+        Syslogger_stop();
+}
+
+
 /**
  * Close the log file or syslog
  */
 void log_close() {
+        log_stop();
         if (Run.flags & Run_UseSyslog) {
                 closelog();
         }
@@ -405,6 +593,476 @@ void vsyslog (int facility_priority, const char *format, va_list arglist) {
 /* ----------------------------------------------------------------- Private */
 
 
+static void _lineInit(Line_T *l, char *buffer, int size) {
+        l->buffer = l->initial = buffer;
+        l->size = size;
+        l->length = 0;
+        *buffer = 0;
+}
+
+
+static void _lineFree(Line_T *l) {
+        if (l->buffer != l->initial)
+                FREE(l->buffer);
+}
+
+
+static void _lineReserve(Line_T *l, int n) {
+        if (l->length + n >= l->size) {
+                int size = l->size * 2 > l->length + n + 1 ? l->size * 2 : l->length + n + 1;
+                if (l->buffer == l->initial)
+                        l->buffer = memcpy(ALLOC(size), l->initial, l->length + 1);
+                else
+                        RESIZE(l->buffer, size);
+                l->size = size;
+        }
+}
+
+
+static void _lineAppend(Line_T *l, const char *s, int n) {
+        _lineReserve(l, n);
+        memcpy(l->buffer + l->length, s, n);
+        l->length += n;
+        l->buffer[l->length] = 0;
+}
+
+
+static void _lineFormat(Line_T *l, const char *s, va_list ap) {
+        va_list ap_copy;
+        va_copy(ap_copy, ap);
+        int n = vsnprintf(l->buffer + l->length, l->size - l->length, s, ap_copy);
+        va_end(ap_copy);
+        if (n < 0) {
+                l->buffer[l->length] = 0;
+                return;
+        }
+        if (n >= l->size - l->length) {
+                _lineReserve(l, n);
+                va_copy(ap_copy, ap);
+                vsnprintf(l->buffer + l->length, l->size - l->length, s, ap_copy);
+                va_end(ap_copy);
+        }
+        l->length += n;
+}
+
+
+/**
+ * Send the message to the syslog server if set, otherwise to the local syslog
+ */
+static void _syslog(int priority, time_t time, const char *message, int length) {
+        if (! Syslogger_send(priority, time, message, length))
+                syslog(priority, "%s", message);
+}
+
+
+/**
+ * Write the line synchronously
+ */
+static void _lineWrite(int priority, Line_T *l) {
+        LOCK(log_mutex)
+        {
+                FILE *output = priority < LOG_INFO ? stderr : stdout;
+                fwrite(l->buffer, 1, l->length, output);
+                fflush(output);
+                if (Run.flags & Run_Log) {
+                        if (Run.flags & Run_UseSyslog)
+                                _syslog(priority, time(NULL), l->buffer, l->length);
+                        else if (LOG)
+                                fwrite(l->buffer, 1, l->length, LOG);
+                }
+        }
+        END_LOCK;
+}
+
+
+/* --------------------------------------------------------- JSON log format */
+
+
+static void _jsonKey(Line_T *l, const char *key) {
+        int n = (int)strlen(key);
+        _lineReserve(l, n + 4);
+        if (l->length && l->buffer[l->length - 1] != '{')
+                l->buffer[l->length++] = ',';
+        l->buffer[l->length++] = '"';
+        memcpy(l->buffer + l->length, key, n);
+        l->length += n;
+        l->buffer[l->length++] = '"';
+        l->buffer[l->length++] = ':';
+        l->buffer[l->length] = 0;
+}
+
+
+/**
+ * Append the escaped string value. Runs of characters which need no escaping are copied at once
+ */
+static void _jsonString(Line_T *l, const char *key, const char *value, int length) {
+        static const char hex[] = "0123456789abcdef";
+        _jsonKey(l, key);
+        if (! value) {
+                _lineAppend(l, "null", 4);
+                return;
+        }
+        if (length < 0)
+                length = (int)strlen(value);
+        while (length > 0 && (value[length - 1] == '\n' || value[length - 1] == '\r'))
+                length--;
+        _lineAppend(l, "\"", 1);
+        for (int i = 0, run = 0; i <= length; i++) {
+                unsigned char c = i < length ? (unsigned char)value[i] : 0;
+                if (i < length && c >= 0x20 && c != '"' && c != '\\')
+                        continue;
+                _lineAppend(l, value + run, i - run);
+                run = i + 1;
+                if (i == length)
+                        break;
+                char escape[6] = {'\\', 0};
+                switch (c) {
+                        case '"':  escape[1] = '"'; break;
+                        case '\\': escape[1] = '\\'; break;
+                        case '\n': escape[1] = 'n'; break;
+                        case '\r': escape[1] = 'r'; break;
+                        case '\t': escape[1] = 't'; break;
+                        default:
+                                _lineAppend(l, (char[]){'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]}, 6);
+                                continue;
+                }
+                _lineAppend(l, escape, 2);
+        }
+        _lineAppend(l, "\"", 1);
+}
+
+
+static void _jsonInteger(Line_T *l, const char *key, long long value) {
+        char digits[24];
+        int i = sizeof(digits);
+        unsigned long long v = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+        do {
+                digits[--i] = '0' + v % 10;
+                v /= 10;
+        } while (v);
+        if (value < 0)
+                digits[--i] = '-';
+        _jsonKey(l, key);
+        _lineAppend(l, digits + i, (int)sizeof(digits) - i);
+}
+
+
+static void _jsonDouble(Line_T *l, const char *key, double value) {
+        char number[32];
+        _jsonKey(l, key);
+        _lineAppend(l, number, snprintf(number, sizeof(number), "%.2f", value));
+}
+
+
+/**
+ * Append the UTC timestamp in the RFC 3339 format
+ */
+static void _jsonTimestamp(Line_T *l, time_t time) {
+        struct tm t;
+        gmtime_r(&time, &t);
+        char text[32];
+        _jsonString(l, "timestamp", text, (int)strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &t));
+}
+
+
+/**
+ * Build the JSON object of a log message
+ */
+static void _jsonText(Line_T *l, int priority, time_t time, const char *text, int length) {
+        _lineAppend(l, "{", 1);
+        _jsonTimestamp(l, time);
+        _jsonString(l, "priority", logPriorityDescription(priority), -1);
+        _jsonString(l, "message", text, length);
+        _lineAppend(l, "}\n", 2);
+}
+
+
+static void _jsonMessage(Line_T *l, int priority, time_t time, const char *s, va_list ap) {
+        char buffer[LOG_RECORD_SIZE];
+        Line_T message;
+        _lineInit(&message, buffer, sizeof(buffer));
+        _lineFormat(&message, s, ap);
+        _jsonText(l, priority, time, message.buffer, message.length);
+        _lineFree(&message);
+}
+
+
+/**
+ * Append the service data related to the event
+ */
+static void _jsonMetrics(Line_T *l, Service_T S) {
+        switch (S->type) {
+                case Service_System:
+                        _jsonDouble(l, "load1", systeminfo.loadavg[0]);
+                        _jsonDouble(l, "load5", systeminfo.loadavg[1]);
+                        _jsonDouble(l, "load15", systeminfo.loadavg[2]);
+                        _jsonDouble(l, "cpu_user", systeminfo.cpu.usage.user);
+                        _jsonDouble(l, "cpu_system", systeminfo.cpu.usage.system);
+                        _jsonDouble(l, "memory_percent", systeminfo.memory.usage.percent);
+                        _jsonDouble(l, "swap_percent", systeminfo.swap.usage.percent);
+                        break;
+                case Service_Process:
+                        if (S->inf.process->pid > 0) {
+                                _jsonInteger(l, "pid", S->inf.process->pid);
+                                _jsonDouble(l, "cpu_percent", S->inf.process->cpu_percent);
+                                _jsonInteger(l, "memory", S->inf.process->mem);
+                                _jsonDouble(l, "memory_percent", S->inf.process->mem_percent);
+                                _jsonInteger(l, "threads", S->inf.process->threads);
+                                _jsonInteger(l, "children", S->inf.process->children);
+                        }
+                        break;
+                case Service_Filesystem:
+                        _jsonDouble(l, "space_percent", S->inf.filesystem->space_percent);
+                        _jsonDouble(l, "inode_percent", S->inf.filesystem->inode_percent);
+                        break;
+                case Service_File:
+                        _jsonInteger(l, "size", S->inf.file->size);
+                        break;
+                default:
+                        break;
+        }
+}
+
+
+/**
+ * Build the JSON object of a service event
+ */
+static void _jsonEvent(Line_T *l, int priority, time_t time, Service_T S, Event_T E) {
+        _lineAppend(l, "{", 1);
+        _jsonTimestamp(l, time);
+        _jsonString(l, "priority", logPriorityDescription(priority), -1);
+        _jsonString(l, "service", S->name, -1);
+        _jsonString(l, "type", servicetypes[S->type], -1);
+        _jsonInteger(l, "event_id", E->id);
+        _jsonString(l, "event", Event_get_description(E), -1);
+        _jsonString(l, "state", E->state <= State_Init ? statenames[E->state] : NULL, -1);
+        _jsonString(l, "action", Event_get_action_description(E), -1);
+        _jsonInteger(l, "count", E->count);
+        _jsonString(l, "message", E->message, -1);
+        _jsonKey(l, "metrics");
+        _lineAppend(l, "{", 1);
+        _jsonMetrics(l, S);
+        _lineAppend(l, "}}\n", 3);
+}
+
+
+/* ---------------------------------------------------------- Log writer */
+
+
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+
+
+/**
+ * Write the iovec array to the file descriptor, continue after partial writes
+ */
+static void _writev(int fd, struct iovec *iov, int count) {
+        while (count > 0) {
+                ssize_t n = writev(fd, iov, count);
+                if (n < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        return;
+                }
+                for (; count > 0 && (size_t)n >= iov->iov_len; iov++, count--)
+                        n -= iov->iov_len;
+                if (count > 0) {
+                        iov->iov_base = (char *)iov->iov_base + n;
+                        iov->iov_len -= n;
+                }
+        }
+}
+
+
+/**
+ * Format the record prefix with the timestamp, which is formatted once per second
+ */
+static int _prefix(char *buffer, time_t time, int priority) {
+        if (time != _writer.timestamp.time) {
+                _writer.timestamp.time = time;
+                Time_fmt(_writer.timestamp.text, sizeof(_writer.timestamp.text), TIMEFORMAT, time);
+        }
+        int length = snprintf(buffer, STRLEN, "[%s] %-8s : ", _writer.timestamp.text, logPriorityDescription(priority));
+        return length < STRLEN ? length : STRLEN - 1;
+}
+
+
+/**
+ * Register the calling thread as a producer if the writer thread is running. The producers are
+ * counted, so log_stop() can wait for them before it drains the ring and log_start() resets it
+ * @return true if the writer is running, the caller must then call _leave() when done with the ring
+ */
+static boolean_t _enter() {
+        __atomic_add_fetch(&_writer.producers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&_writer.running, __ATOMIC_SEQ_CST))
+                return true;
+        __atomic_sub_fetch(&_writer.producers, 1, __ATOMIC_SEQ_CST);
+        return false;
+}
+
+
+static void _leave() {
+        __atomic_sub_fetch(&_writer.producers, 1, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * Write up to LOG_BATCH records from the ring. Must be called by one thread at a time with _writer.mutex locked
+ * @return The number of records written
+ */
+static int _writeBatch() {
+        int count = 0, nout = 0, nerr = 0, nlog = 0;
+        char prefix[LOG_BATCH + 1][STRLEN];
+        struct iovec out[LOG_BATCH + 1], err[LOG_BATCH + 1], log[2 * (LOG_BATCH + 1)];
+        unsigned long long start = _writer.tail;
+        for (; count < LOG_BATCH; count++) {
+                LogRecord_T r = &_writer.ring[(start + count) & (LOG_RING_SIZE - 1)];
+                if (__atomic_load_n(&r->sequence, __ATOMIC_ACQUIRE) != start + count + 1)
+                        break;
+                if (r->priority < LOG_INFO)
+                        err[nerr++] = (struct iovec){.iov_base = r->message, .iov_len = r->length};
+                else
+                        out[nout++] = (struct iovec){.iov_base = r->message, .iov_len = r->length};
+                if (Run.flags & Run_Log) {
+                        if (Run.flags & Run_UseSyslog) {
+                                _syslog(r->priority, r->time, r->message, r->length);
+                        } else if (LOG) {
+                                if (! (Run.flags & Run_LogJson))
+                                        log[nlog++] = (struct iovec){.iov_base = prefix[count], .iov_len = _prefix(prefix[count], r->time, r->priority)};
+                                log[nlog++] = (struct iovec){.iov_base = r->message, .iov_len = r->length};
+                        }
+                }
+        }
+        // Report the dropped messages once the ring has room again
+        char text[STRLEN], buffer[STRLEN];
+        Line_T dropped;
+        _lineInit(&dropped, buffer, sizeof(buffer));
+        unsigned long long lost = __atomic_load_n(&Run.timing.logdropped, __ATOMIC_RELAXED);
+        if (lost != _writer.reported) {
+                int length = snprintf(text, sizeof(text), "Log queue overflow -- %llu messages dropped\n", lost - _writer.reported);
+                _writer.reported = lost;
+                if (Run.flags & Run_LogJson)
+                        _jsonText(&dropped, LOG_WARNING, time(NULL), text, length);
+                else
+                        _lineAppend(&dropped, text, length);
+                err[nerr++] = (struct iovec){.iov_base = dropped.buffer, .iov_len = dropped.length};
+                if (Run.flags & Run_Log) {
+                        if (Run.flags & Run_UseSyslog) {
+                                _syslog(LOG_WARNING, time(NULL), dropped.buffer, dropped.length);
+                        } else if (LOG) {
+                                if (! (Run.flags & Run_LogJson))
+                                        log[nlog++] = (struct iovec){.iov_base = prefix[LOG_BATCH], .iov_len = _prefix(prefix[LOG_BATCH], time(NULL), LOG_WARNING)};
+                                log[nlog++] = (struct iovec){.iov_base = dropped.buffer, .iov_len = dropped.length};
+                        }
+                }
+        }
+        _writev(STDOUT_FILENO, out, nout);
+        _writev(STDERR_FILENO, err, nerr);
+        if (LOG)
+                _writev(fileno(LOG), log, nlog);
+        // Release the slots for the producers
+        for (int i = 0; i < count; i++) {
+                LogRecord_T r = &_writer.ring[(start + i) & (LOG_RING_SIZE - 1)];
+                if (r->message != r->buffer)
+                        FREE(r->message);
+                __atomic_store_n(&r->sequence, start + i + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        }
+        _writer.tail = start + count;
+        _lineFree(&dropped);
+        return count;
+}
+
+
+static void *_writerThread(void *args) {
+        set_signal_block();
+        LOCK(_writer.mutex)
+        {
+                while (true) {
+                        if (! _writeBatch()) {
+                                if (! __atomic_load_n(&_writer.running, __ATOMIC_ACQUIRE))
+                                        break;
+                                struct timeval now;
+                                gettimeofday(&now, NULL);
+                                long long deadline = (long long)now.tv_sec * 1000LL + now.tv_usec / 1000 + LOG_WAIT;
+                                struct timespec wait = {.tv_sec = deadline / 1000, .tv_nsec = (deadline % 1000) * 1000000};
+                                Sem_timeWait(_writer.cond, _writer.mutex, wait);
+                        }
+                }
+        }
+        END_LOCK;
+        return NULL;
+}
+
+
+/**
+ * Claim a slot in the ring buffer of the writer thread. If the ring is full, the message is counted as dropped
+ * @return The record or NULL if the ring is full
+ */
+static LogRecord_T _claim(unsigned long long *position) {
+        *position = __atomic_load_n(&_writer.head, __ATOMIC_RELAXED);
+        while (true) {
+                LogRecord_T r = &_writer.ring[*position & (LOG_RING_SIZE - 1)];
+                long long d = (long long)(__atomic_load_n(&r->sequence, __ATOMIC_ACQUIRE) - *position);
+                if (d == 0) {
+                        if (__atomic_compare_exchange_n(&_writer.head, position, *position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                                return r;
+                } else if (d < 0) {
+                        __atomic_add_fetch(&Run.timing.logdropped, 1, __ATOMIC_RELAXED);
+                        return NULL;
+                } else {
+                        *position = __atomic_load_n(&_writer.head, __ATOMIC_RELAXED);
+                }
+        }
+}
+
+
+/**
+ * Publish the record built in the line to the writer thread
+ */
+static void _commit(LogRecord_T r, unsigned long long position, int priority, time_t time, Line_T *l) {
+        r->message = l->buffer;
+        r->length = l->length;
+        r->priority = priority;
+        r->time = time;
+        __atomic_store_n(&r->sequence, position + 1, __ATOMIC_RELEASE);
+        Sem_signal(_writer.cond);
+}
+
+
+/**
+ * Push the message to the ring buffer of the writer thread
+ */
+static void _push(int priority, const char *s, va_list ap) {
+        unsigned long long position;
+        LogRecord_T r = _claim(&position);
+        if (r) {
+                Line_T l;
+                time_t now = time(NULL);
+                _lineInit(&l, r->buffer, sizeof(r->buffer));
+                if (Run.flags & Run_LogJson)
+                        _jsonMessage(&l, priority, now, s, ap);
+                else
+                        _lineFormat(&l, s, ap);
+                _commit(r, position, priority, now, &l);
+        }
+}
+
+
+static void _pushEvent(int priority, Service_T S, Event_T E) {
+        unsigned long long position;
+        LogRecord_T r = _claim(&position);
+        if (r) {
+                Line_T l;
+                time_t now = time(NULL);
+                _lineInit(&l, r->buffer, sizeof(r->buffer));
+                _jsonEvent(&l, priority, now, S, E);
+                _commit(r, position, priority, now, &l);
+        }
+}
+
+
+#endif
+
+
 /**
  * Open a log file or syslog
  */
@@ -449,6 +1107,44 @@ static const char *logPriorityDescription(int p) {
  */
 static void log_log(int priority, const char *s, va_list ap) {
         ASSERT(s);
+#if defined HAVE_ATOMIC_BUILTINS && defined HAVE_SYS_UIO_H
+        if (_enter()) {
+                if (priority > LOG_CRIT) {
+                        _push(priority, s, ap);
+                } else {
+                        LOCK(_writer.mutex)
+                        {
+                                // Write the queued messages first, so the log keeps the order and the messages which explain an abort are not lost
+                                while (_writeBatch())
+                                        ;
+                                log_write(priority, s, ap);
+                        }
+                        END_LOCK;
+                }
+                _leave();
+                return;
+        }
+#endif
+        log_write(priority, s, ap);
+}
+
+
+/**
+ * Write the message synchronously
+ * @param priority A message priority
+ * @param s A formated (printf-style) string to log
+ */
+static void log_write(int priority, const char *s, va_list ap) {
+        ASSERT(s);
+        if (Run.flags & Run_LogJson) {
+                char buffer[LOG_RECORD_SIZE];
+                Line_T l;
+                _lineInit(&l, buffer, sizeof(buffer));
+                _jsonMessage(&l, priority, time(NULL), s, ap);
+                _lineWrite(priority, &l);
+                _lineFree(&l);
+                return;
+        }
 #ifdef HAVE_VA_COPY
         va_list ap_copy;
 #endif
@@ -466,13 +1162,12 @@ static void log_log(int priority, const char *s, va_list ap) {
                 fflush(output);
                 if (Run.flags & Run_Log) {
                         if (Run.flags & Run_UseSyslog) {
-#ifdef HAVE_VA_COPY
-                                va_copy(ap_copy, ap);
-                                vsyslog(priority, s, ap_copy);
-                                va_end(ap_copy);
-#else
-                                vsyslog(priority, s, ap);
-#endif
+                                char buffer[LOG_RECORD_SIZE];
+                                Line_T l;
+                                _lineInit(&l, buffer, sizeof(buffer));
+                                _lineFormat(&l, s, ap);
+                                _syslog(priority, time(NULL), l.buffer, l.length);
+                                _lineFree(&l);
                         } else if (LOG) {
                                 char datetime[STRLEN];
                                 fprintf(LOG, "[%s] %-8s : ", Time_fmt(datetime, sizeof(datetime), TIMEFORMAT, time(NULL)), logPriorityDescription(priority));
@@ -491,6 +1186,14 @@ static void log_log(int priority, const char *s, va_list ap) {
 }
 
 
+static void log_logf(int priority, const char *s, ...) {
+        va_list ap;
+        va_start(ap, s);
+        log_log(priority, s, ap);
+        va_end(ap);
+}
+
+
 static void log_backtrace() {
 #ifdef HAVE_BACKTRACE
         int i, frames;
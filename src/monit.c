@@ -46,6 +46,10 @@
 #include <getopt.h>
 #endif
 
+#ifdef HAVE_STDDEF_H
+#include <stddef.h>
+#endif
+
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
@@ -70,6 +74,10 @@
 #include <sys/wait.h>
 #endif
 
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+
 #include "monit.h"
 #include "net.h"
 #include "ProcessTree.h"
@@ -78,11 +86,14 @@
 #include "engine.h"
 #include "client.h"
 #include "MMonit.h"
+#include "bench.h"
+#include "watchdog.h"
 
 // libmonit
 #include "Bootstrap.h"
 #include "io/Dir.h"
 #include "io/File.h"
+#include "io/FileCache.h"
 #include "system/Time.h"
 #include "util/List.h"
 #include "exceptions/AssertException.h"
@@ -126,6 +137,8 @@ struct Run_T Run;                      /**< Struct holding runtime constants */
 Service_T servicelist;                /**< The service list (created in p.y) */
 Service_T servicelist_conf;   /**< The service list in conf file (c. in p.y) */
 ServiceGroup_T servicegrouplist;/**< The service group list (created in p.y) */
+Table_T servicetable;           /**< Service name index (created in p.y) */
+Table_T servicegrouptable;/**< Service group name index (created in p.y) */
 SystemInfo_T systeminfo;                              /**< System infomation */
 
 Thread_T heartbeatThread;
@@ -146,6 +159,8 @@ char *sslnames[] = {"auto", "v2", "v3", "tlsv1", "tlsv1.1", "tlsv1.2"};
 char *socketnames[] = {"unix", "IP", "IPv4", "IPv6"};
 char *timestampnames[] = {"modify/change time", "access time", "change time", "modify time"};
 char *httpmethod[] = {"", "HEAD", "GET"};
+char *statenames[] = {"succeeded", "failed", "changed", "not changed", "init"};
+char *timingnames[] = {"1ms", "10ms", "100ms", "500ms", "1s", "5s", "30s", "inf"};
 
 
 /* ------------------------------------------------------------------ Public */
@@ -165,6 +180,9 @@ int main(int argc, char **argv) {
 #endif
         init_env();
         handle_options(argc, argv);
+        // The benchmark uses its own fixtures unless a control file was given with -c
+        if (IS(argv[optind], "bench") && ! Run.files.control && ! Bench_fixtures())
+                exit(1);
         do_init();
         do_action(argv);
         do_exit();
@@ -193,6 +211,28 @@ boolean_t do_wakeupcall() {
 /* ----------------------------------------------------------------- Private */
 
 
+/**
+ * Sleep until the next poll cycle. Services with a millisecond interval
+ * schedule are checked while waiting. The wait is interrupted by signals
+ * and pending actions.
+ */
+static void _sleep() {
+        long long cycle = Time_monotonic() + Run.polltime * 1000LL;
+        while (! (Run.flags & (Run_ActionPending | Run_Stopped | Run_DoReload | Run_DoWakeup))) {
+                long long next = validate_interval();
+                if (! next || next > cycle)
+                        next = cycle;
+                long long now = Time_monotonic();
+                if (now >= cycle)
+                        break;
+                if (next > now) {
+                        struct timespec wait = {.tv_sec = (next - now) / 1000, .tv_nsec = ((next - now) % 1000) * 1000000};
+                        nanosleep(&wait, NULL);
+                }
+        }
+}
+
+
 static void _validateOnce() {
         if (State_open()) {
                 State_restore();
@@ -314,6 +354,103 @@ static void do_init() {
 }
 
 
+/**
+ * Relink the service chain starting at head, so the parsed services which are replaced by running services are
+ * substituted in place
+ * @param head The first service in the chain
+ * @param offset The offset of the link field (next or next_conf) in the service
+ * @param reused The map of parsed services to running services
+ * @return The new first service in the chain
+ */
+static Service_T _relink(Service_T head, size_t offset, Table_T reused) {
+        Service_T first = NULL, last = NULL;
+        for (Service_T s = head, next; s; s = next) {
+                next = *(Service_T *)((char *)s + offset);
+                Service_T r = Table_get(reused, s);
+                if (! r)
+                        r = s;
+                if (last)
+                        *(Service_T *)((char *)last + offset) = r;
+                else
+                        first = r;
+                last = r;
+        }
+        if (last)
+                *(Service_T *)((char *)last + offset) = NULL;
+        return first;
+}
+
+
+/**
+ * Replace the parsed services which configuration didn't change with the running instances, so they keep their
+ * runtime state (statistics, events, compiled patterns, schedule). The service is unchanged if it has the same name,
+ * type and configuration digest and the global statements didn't change. The parsed copies of reused services and
+ * the running services which were removed or changed are freed.
+ * @param services The running services in configuration order
+ * @param groups The running service groups
+ * @param table The running service name index
+ * @param digest The digest of the running global configuration
+ */
+static void _reuseServices(Service_T services, ServiceGroup_T groups, Table_T table, unsigned char digest[16]) {
+        int reused = 0, added = 0, removed = 0;
+        Table_T map = Table_new(0, NULL, NULL);
+        boolean_t global = memcmp(digest, Run.digest, sizeof(Run.digest)) == 0;
+        for (Service_T s = servicelist_conf; s; s = s->next_conf) {
+                Service_T o = Table_get(table, s->name);
+                if (global && o && o->type == s->type && memcmp(o->digest, s->digest, sizeof(s->digest)) == 0) {
+                        Table_remove(table, o->name);
+                        Table_put(map, s, o);
+                        reused++;
+                } else {
+                        added++;
+                }
+        }
+        // The services remaining in the old index were removed or changed
+        List_T unused = List_new();
+        for (Service_T o = services; o; o = o->next_conf) {
+                if (Table_get(table, o->name) == o) {
+                        List_append(unused, o);
+                        removed++;
+                }
+        }
+        if (reused) {
+                List_T parsed = List_new();
+                for (Service_T s = servicelist_conf; s; s = s->next_conf)
+                        if (Table_get(map, s))
+                                List_append(parsed, s);
+                servicelist = _relink(servicelist, offsetof(struct Service_T, next), map);
+                servicelist_conf = _relink(servicelist_conf, offsetof(struct Service_T, next_conf), map);
+                for (ServiceGroup_T g = servicegrouplist; g; g = g->next) {
+                        for (list_t m = g->members->head; m; m = m->next) {
+                                Service_T o = Table_get(map, m->e);
+                                if (o)
+                                        m->e = o;
+                        }
+                }
+                for (list_t p = parsed->head; p; p = p->next) {
+                        Service_T s = p->e;
+                        Service_T o = Table_get(map, s);
+                        Table_remove(servicetable, s->name);
+                        Table_put(servicetable, o->name, o);
+                        if (Run.system == s)
+                                Run.system = o;
+                        gc_service(&s);
+                }
+                List_free(&parsed);
+        }
+        while (List_length(unused) > 0) {
+                Service_T o = List_pop(unused);
+                gc_service(&o);
+        }
+        List_free(&unused);
+        if (groups)
+                gc_servicegroup(&groups);
+        Table_free(&table);
+        Table_free(&map);
+        LogInfo("Reload: %d services unchanged, %d new or changed, %d removed or changed\n", reused, added, removed);
+}
+
+
 /**
  * Re-Initialize the application - called if a
  * monit daemon receives the SIGHUP signal.
@@ -335,6 +472,8 @@ static void do_reinit() {
                 heartbeatRunning = false;
         }
 
+        Watchdog_stop();
+
         Run.flags &= ~Run_DoReload;
 
         /* Stop http interface */
@@ -345,20 +484,41 @@ static void do_reinit() {
         State_save();
         State_close();
 
+        /* Detach the running services, the unchanged ones are reused after parsing with their runtime state */
+        Service_T services = servicelist_conf;
+        ServiceGroup_T groups = servicegrouplist;
+        Table_T table = servicetable;
+        unsigned char digest[16];
+        memcpy(digest, Run.digest, sizeof(digest));
+        servicelist = servicelist_conf = NULL;
+        servicegrouplist = NULL;
+        servicetable = NULL;
+        if (servicegrouptable)
+                Table_free(&servicegrouptable);
+
+        /* Stop the log writer and syslog threads, the log settings they read are freed and parsed again */
+        log_stop();
+
         /* Run the garbage collector */
-        gc();
+        gc_config();
+
+        /* Close the cached /proc and /sys descriptors, the monitored devices and interfaces may change */
+        FileCache_clear();
 
         if (! parse(Run.files.control)) {
                 LogError("%s stopped -- error parsing configuration file\n", prog);
                 exit(1);
         }
 
+        _reuseServices(services, groups, table, digest);
+
         /* Close the current log */
         log_close();
 
         /* Reinstall the log system */
         if (! log_init())
                 exit(1);
+        log_start();
 
         /* Did we find any services ?  */
         if (! servicelist) {
@@ -390,6 +550,8 @@ static void do_reinit() {
                 Thread_create(heartbeatThread, heartbeat, NULL);
                 heartbeatRunning = true;
         }
+
+        Watchdog_start();
 }
 
 
@@ -413,13 +575,11 @@ static void do_action(char **args) {
                         int errors = 0;
                         List_T services = List_new();
                         if (Run.mygroup) {
-                                for (ServiceGroup_T sg = servicegrouplist; sg; sg = sg->next) {
-                                        if (IS(Run.mygroup, sg->name)) {
-                                                for (list_t m = sg->members->head; m; m = m->next) {
-                                                        Service_T s = m->e;
-                                                        List_append(services, s->name);
-                                                }
-                                                break;
+                                ServiceGroup_T sg = Util_getServiceGroup(Run.mygroup);
+                                if (sg) {
+                                        for (list_t m = sg->members->head; m; m = m->next) {
+                                                Service_T s = m->e;
+                                                List_append(services, s->name);
                                         }
                                 }
                                 if (List_length(services) == 0) {
@@ -456,6 +616,18 @@ static void do_action(char **args) {
                 char *type = args[++optind];
                 if (! HttpClient_report(type))
                         exit(1);
+        } else if (IS(action, "stats")) {
+                if (! HttpClient_stats())
+                        exit(1);
+        } else if (IS(action, "bench")) {
+                int cycles = BENCH_CYCLES;
+                char *count = args[++optind];
+                if (count && sscanf(count, "%d", &cycles) != 1) {
+                        printf("Invalid syntax - usage: bench [cycles]\n");
+                        exit(1);
+                }
+                if (! Bench_run(cycles))
+                        exit(1);
         } else if (IS(action, "procmatch")) {
                 char *pattern = args[++optind];
                 if (! pattern) {
@@ -496,6 +668,8 @@ static void do_exit() {
                         heartbeatRunning = false;
                 }
 
+                Watchdog_stop();
+
                 LogInfo("Monit daemon with pid [%d] stopped\n", (int)getpid());
 
                 /* send the monit stop notification */
@@ -535,6 +709,9 @@ static void do_default() {
                 if (! (Run.flags & Run_Foreground))
                         daemonize();
 
+                /* Write the log from a dedicated thread, so the validation and http threads don't block on the log I/O */
+                log_start();
+
                 if (! file_createPidFile(Run.files.pid)) {
                         LogError("Monit daemon died\n");
                         exit(1);
@@ -570,17 +747,24 @@ static void do_default() {
                         heartbeatRunning = true;
                 }
 
+                Watchdog_start();
+
                 while (true) {
                         validate();
+                        long long start = Time_monotonicMicro();
                         State_save();
+                        Util_updateTiming(&Run.timing.state, start);
 
                         /* In the case that there is no pending action then sleep */
                         if (! (Run.flags & Run_ActionPending) && ! (Run.flags & Run_Stopped))
-                                sleep(Run.polltime);
+                                _sleep();
 
                         if (Run.flags & Run_DoWakeup) {
                                 Run.flags &= ~Run_DoWakeup;
                                 LogInfo("Awakened by User defined signal 1\n");
+                                /* Check the services with own schedule immediately too */
+                                for (Service_T s = servicelist; s; s = s->next)
+                                        s->every.next = 0LL;
                         }
 
                         if (Run.flags & Run_Stopped)
@@ -827,9 +1011,11 @@ static void help() {
                " status [name]         - Print full status information for service(s)\n"
                " summary [name]        - Print short status information for service(s)\n"
                " report [up|down|..]   - Report state of services. See manual for options\n"
+               " stats                 - Print duration statistics of Monit checks\n"
                " quit                  - Kill the monit daemon process\n"
                " validate              - Check all services and start if not running\n"
-               " procmatch <pattern>   - Test process matching pattern\n",
+               " procmatch <pattern>   - Test process matching pattern\n"
+               " bench [cycles]        - Run validation cycles and report Monit's throughput\n",
                prog);
 }
 
@@ -128,9 +128,13 @@ typedef enum {
 #include "system/Process.h"
 #include "util/Str.h"
 #include "util/StringBuffer.h"
+#include "util/Table.h"
+#include "util/Arena.h"
+#include "util/Atom.h"
 #include "system/Link.h"
 #include "statistics/Statistics.h"
 #include "thread/Thread.h"
+#include "system/Time.h"
 
 
 #define MONITRC            "monitrc"
@@ -155,12 +159,15 @@ typedef enum {
 #define PORT_SMTPS         465
 #define PORT_HTTP          80
 #define PORT_HTTPS         443
+#define PORT_SYSLOG        514
 
 #define SSL_TIMEOUT        15000
 #define SMTP_TIMEOUT       30000
 
 #define START_DELAY        0
 
+#define WATCHDOG_TIMEOUT   300
+
 
 //FIXME: refactor Run_Flags to bit field
 typedef enum {
@@ -177,7 +184,10 @@ typedef enum {
         Run_Stopped              = 0x400,                          /**< Stop Monit */
         Run_DoReload             = 0x800,                        /**< Reload Monit */
         Run_DoWakeup             = 0x1000,                       /**< Wakeup Monit */
-        Run_Batch                = 0x2000                      /**< CLI batch mode */
+        Run_Batch                = 0x2000,                     /**< CLI batch mode */
+        Run_SpreadChecks         = 0x4000, /**< Spread checks over the poll interval */
+        Run_Bench                = 0x8000,  /**< Benchmark mode, no alerts and actions */
+        Run_LogJson              = 0x10000                /**< Log as JSON lines */
 } __attribute__((__packed__)) Run_Flags;
 
 
@@ -197,7 +207,8 @@ typedef enum {
         Every_Cycle = 0,
         Every_SkipCycles,
         Every_Cron,
-        Every_NotInCron
+        Every_NotInCron,
+        Every_Interval
 } __attribute__((__packed__)) Every_Type;
 
 
@@ -331,7 +342,10 @@ typedef enum {
         Resource_ReadOperations,
         Resource_WriteBytes,
         Resource_WriteOperations,
-        Resource_ServiceTime
+        Resource_ServiceTime,
+        Resource_CpuSteal,
+        Resource_CpuGuest,
+        Resource_CpuCore
 } __attribute__((__packed__)) Resource_Type;
 
 
@@ -379,6 +393,10 @@ typedef enum {
 #define MD_SIZE 65
 
 
+/* Number of the duration histogram buckets (see timingnames) */
+#define TIMING_BUCKETS 8
+
+
 #define ICMP_SIZE 64
 #define ICMP_MAXSIZE 1500
 #define ICMP_ATTEMPT_COUNT 3
@@ -524,7 +542,7 @@ typedef struct Mmonit_T {
 
 /** Defines a mailinglist object */
 typedef struct Mail_T {
-        char *to;                         /**< Mail address for alert notification */
+        const char *to;                   /**< Mail address for alert notification */
         Address_T from;                                 /**< The mail from address */
         Address_T replyto;                          /**< Optional reply-to address */
         char *subject;                                       /**< The mail subject */
@@ -570,7 +588,19 @@ typedef struct SystemInfo_T {
                         float user;         /**< Total CPU in use in user space [%] */
                         float system;     /**< Total CPU in use in kernel space [%] */
                         float wait;            /**< Total CPU in use in waiting [%] */
+                        float steal;     /**< Total CPU stolen by the hypervisor [%] */
+                        float guest;     /**< Total CPU spent running vCPU guests [%] */
+                        float irq;            /**< Total CPU spent in hardware irq [%] */
+                        float softirq;        /**< Total CPU spent in software irq [%] */
                 } usage;
+                struct {
+                        int count;                 /**< Number of per-core samples */
+                        float max;                /**< Highest single core usage [%] */
+                        struct {
+                                int id;                               /**< CPU core id */
+                                float usage;                       /**< Core usage [%] */
+                        } *sample;         /**< Per-core samples of the online cores */
+                } core;
         } cpu;
         struct {
                 uint64_t size;                      /**< Maximal system real memory */
@@ -592,7 +622,7 @@ typedef struct SystemInfo_T {
         struct timeval collected;                                             /**< When were data collected */
         uint64_t booted; /**< System boot time (seconds since UNIX epoch, using platform-agnostic uint64_t) */
         double time;                                                                      /**< 1/10 seconds */
-        double time_prev;                                                                 /**< 1/10 seconds */
+        long long monotonic;                       /**< Monotonic time of the last process tree update [ms] */
 } SystemInfo_T;
 
 
@@ -621,7 +651,7 @@ typedef struct Outgoing_T {
 
 /** Defines a port object */
 typedef struct Port_T {
-        char *hostname;                                     /**< Hostname to check */
+        const char *hostname;                               /**< Hostname to check */
         union {
                 struct {
                         char *pathname;                  /**< Unix socket pathname */
@@ -783,18 +813,36 @@ typedef struct ActionRate_T {
 /** Defines when to run a check for a service. This type suports both the old
  cycle based every statement and the new cron-format version */
 typedef struct Every_T {
-        Every_Type type; /**< 0 = not set, 1 = cycle, 2 = cron, 3 = negated cron */
+        Every_Type type; /**< 0 = not set, 1 = cycle, 2 = cron, 3 = negated cron, 4 = interval */
         time_t last_run;
+        long long next; /**< Monotonic time of the next interval, spread or cron based check [ms] */
+        TimeCron_T crontab; /**< The cron string compiled at parse time */
         union {
                 struct {
                         int number; /**< Check this program at a given cycles */
                         int counter; /**< Counter for number. When counter == number, check */
                 } cycle; /**< Old cycle based every check */
+                struct {
+                        int base; /**< Configured check interval [ms] */
+                        int max; /**< Maximum adaptive check interval [ms], 0 if adaptive mode is disabled */
+                        int current; /**< Current check interval [ms] */
+                        boolean_t nearLimit; /**< Some resource value approached its limit in the last check */
+                } interval; /**< Check interval independent of the poll cycle */
                 char *cron; /* A crontab format string */
         } spec;
 } Every_T;
 
 
+/** Defines the duration statistics of a monitoring operation */
+typedef struct Timing_T {
+        unsigned long long count;                     /**< Number of measurements */
+        unsigned long long total;                          /**< Total duration [us] */
+        unsigned long long last;                            /**< Last duration [us] */
+        unsigned long long max;                          /**< Maximum duration [us] */
+        unsigned long long histogram[TIMING_BUCKETS]; /**< Measurements per bucket */
+} Timing_T;
+
+
 typedef struct Status_T {
         boolean_t initialized;                 /**< true if status was initialized */
         Operator_Type operator;                           /**< Comparison operator */
@@ -903,7 +951,7 @@ typedef struct Perm_T {
 typedef struct Match_T {
         boolean_t ignore;                                        /**< Ignore match */
         boolean_t not;                                           /**< Invert match */
-        char    *match_string;                                   /**< Match string */ //FIXME: union?
+        const char *match_string;                                /**< Match string */ //FIXME: union?
         char    *match_path;                         /**< File with matching rules */ //FIXME: union?
         regex_t *regex_comp;                                    /**< Match compile */
         StringBuffer_T log;    /**< The temporary buffer used to record the matches */
@@ -1165,6 +1213,7 @@ typedef struct Service_T {
         EventAction_T action_MONIT_START;  /**< Monit instance start/reload action */
         EventAction_T action_MONIT_STOP;           /**< Monit instance stop action */
         EventAction_T action_ACTION;           /**< Action requested by CLI or GUI */
+        EventAction_T action_MONIT_STALL;   /**< Monit stalled in a service check */
 
         /** Runtime parameters */
         int                error;                          /**< Error flags bitmap */
@@ -1195,7 +1244,15 @@ typedef struct Service_T {
         /** Context specific parameters */
         char *path;  /**< Path to the filesys, file, directory or process pid file */
 
+        Timing_T timing;                              /**< Service check duration */
+        unsigned char digest[16];           /**< Digest of the service configuration */
+        struct {
+                unsigned int count;           /**< Number of consecutive stalled checks */
+                long long until;   /**< Monotonic time [ms] the service is isolated till */
+        } stall;
+
         /** For internal use */
+        Arena_T arena;    /**< The service and its rules are allocated from this arena */
         Mutex_T mutex;                  /**< Mutex used for action synchronization */
         struct Service_T *next;                         /**< next service in chain */
         struct Service_T *next_conf;      /**< next service according to conf file */
@@ -1207,7 +1264,7 @@ typedef struct myevent *Event_T;
 
 
 typedef struct ServiceGroup_T {
-        char *name;                                     /**< name of service group */
+        const char *name;                               /**< name of service group */
         List_T members;                                 /**< Service group members */
 
         /** For internal use */
@@ -1241,6 +1298,38 @@ struct Run_T {
         int  handler_queue[Handler_Max + 1];       /**< The handlers queue counter */
         Service_T system;                          /**< The general system service */
         char *eventlist_dir;                   /**< The event queue base directory */
+        unsigned char digest[16];   /**< Digest of the global configuration statements */
+
+        /** Monit self-instrumentation: durations of the validation stages */
+        struct {
+                Timing_T cycle;                      /**< Whole validation cycle */
+                Timing_T events;                        /**< Event queue processing */
+                Timing_T system;                     /**< System information update */
+                Timing_T processes;                       /**< Process tree update */
+                Timing_T state;                                      /**< State save */
+                Timing_T parse;                           /**< Control file parsing */
+                unsigned long long overruns;  /**< Cycles which exceeded the poll time */
+                unsigned long long stalls;   /**< Checks which exceeded the watchdog timeout */
+                unsigned long long logdropped; /**< Messages dropped by the log writer queue */
+                unsigned long long syslogsent;       /**< Messages sent to the syslog server */
+                unsigned long long syslogdropped; /**< Messages dropped by the syslog queue */
+                unsigned long long syslogerrors;   /**< Syslog server connect and write errors */
+                unsigned long long credentialhits;   /**< HTTP logins verified from the credential cache */
+                unsigned long long credentialmisses; /**< HTTP logins verified by password check */
+        } timing;
+
+        /** Syslog server, if not set, the local syslog is used */
+        struct {
+                char *host;                                     /**< Server hostname */
+                int port;                                           /**< Server port */
+                Socket_Type type;                       /**< Socket_Udp or Socket_Tcp */
+        } syslog;
+
+        /** Watchdog of hung service checks */
+        struct {
+                int timeout;       /**< Check duration [s] considered as stall, 0 = off */
+                boolean_t isolate;     /**< Skip the stalled service in the next cycles */
+        } watchdog;
 
         /** An object holding Monit HTTP interface setup */
         struct {
@@ -1290,9 +1379,13 @@ extern struct Run_T   Run;
 extern Service_T      servicelist;
 extern Service_T      servicelist_conf;
 extern ServiceGroup_T servicegrouplist;
+extern Table_T        servicetable;
+extern Table_T        servicegrouptable;
 extern SystemInfo_T   systeminfo;
 
 extern char *actionnames[];
+extern char *timingnames[];
+extern char *statenames[];
 extern char *modenames[];
 extern char *onrebootnames[];
 extern char *checksumnames[];
@@ -1323,6 +1416,8 @@ boolean_t control_service(const char *, Action_Type);
 boolean_t control_service_string(List_T, const char *);
 void  spawn(Service_T, command_t, Event_T);
 boolean_t log_init();
+void  log_start();
+void  log_stop();
 void  LogEmergency(const char *, ...) __attribute__((format (printf, 1, 2)));
 void  LogAlert(const char *, ...) __attribute__((format (printf, 1, 2)));
 void  LogCritical(const char *, ...) __attribute__((format (printf, 1, 2)));
@@ -1331,6 +1426,7 @@ void  LogWarning(const char *, ...) __attribute__((format (printf, 1, 2)));
 void  LogNotice(const char *, ...) __attribute__((format (printf, 1, 2)));
 void  LogInfo(const char *, ...) __attribute__((format (printf, 1, 2)));
 void  LogDebug(const char *, ...) __attribute__((format (printf, 1, 2)));
+void  LogEvent(int, Service_T, Event_T);
 void  vLogEmergency(const char *, va_list ap);
 void  vLogAlert(const char *, va_list ap);
 void  vLogCritical(const char *, va_list ap);
@@ -1347,8 +1443,12 @@ void vsyslog (int, const char *, va_list);
 #endif /* HAVE_SYSLOG */
 #endif /* HAVE_VSYSLOG */
 int   validate();
+long long validate_interval();
 void  daemonize();
 void  gc();
+void  gc_config();
+void  gc_service(Service_T *);
+void  gc_servicegroup(ServiceGroup_T *);
 void  gc_mail_list(Mail_T *);
 void  gccmd(command_t *);
 void  gc_event(Event_T *e);
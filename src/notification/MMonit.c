@@ -154,7 +154,7 @@ Handler_Type MMonit_send(Event_T E) {
         /* The event is sent to mmonit just once - only in the case that the state changed */
         if (! Run.mmonits || (E && ! E->state_changed))
                 return Handler_Succeeded;
-        StringBuffer_T sb = StringBuffer_create(256);
+        StringBuffer_T sb = StringBuffer_borrow(256);
         for (Mmonit_T C = Run.mmonits; C; C = C->next) {
                 Socket_T  socket = Socket_create(C->url->hostname, C->url->port, Socket_Tcp, Socket_Ip, &(C->ssl), C->timeout);
                 if (! socket) {
@@ -177,7 +177,7 @@ Handler_Type MMonit_send(Event_T E) {
                 if (socket)
                         Socket_free(&socket);
         }
-        StringBuffer_free(&sb);
+        StringBuffer_release(&sb);
         return rv;
 }
 
@@ -125,10 +125,12 @@
 #include "ProcessTree.h"
 #include "device.h"
 #include "processor.h"
+#include "md5.h"
 
 // libmonit
 #include "io/File.h"
 #include "util/Str.h"
+#include "system/Time.h"
 #include "thread/Thread.h"
 
 
@@ -162,6 +164,10 @@ extern char *argyytext;
 extern char *currentfile;
 extern char *argcurrentfile;
 extern int buffer_stack_ptr;
+extern md5_context_t globaldigest;
+extern md5_context_t *servicedigests;
+extern int servicedigests_count;
+extern md5_context_t *currentdigest;
 
 /* Local variables */
 static int cfg_errflag = 0;
@@ -211,6 +217,10 @@ static Digest_Type digesttype = Digest_Cleartext;
 
 #define BITMAP_MAX (sizeof(long long) * 8)
 
+/* Allocate a cleared rule object of the current service from its arena, it
+ is released together with the service */
+#define NEWRULE(p) ARENA_NEW(current->arena, p)
+
 
 /* -------------------------------------------------------------- Prototypes */
 
@@ -262,10 +272,13 @@ static Gid_T addgid(Gid_T);
 static void  addeuid(uid_t);
 static void  addegid(gid_t);
 static void  addeventaction(EventAction_T *, Action_Type, Action_Type);
+static void  _addeventaction(Arena_T, EventAction_T *, Action_Type, Action_Type);
+static command_t _arenacommand(Arena_T, command_t *);
 static void  prepare_urlrequest(URL_T U);
 static void  seturlrequest(int, char *);
 static void  setlogfile(char *);
 static void  setpidfile(char *);
+static void  setinterval(int, int);
 static void  reset_sslset();
 static void  reset_mailset();
 static void  reset_mailserverset();
@@ -315,7 +328,7 @@ static void _setSSLOptions(SslOptions_T options);
 }
 
 %token IF ELSE THEN FAILED
-%token SET LOGFILE FACILITY DAEMON SYSLOG MAILSERVER HTTPD ALLOW REJECTOPT ADDRESS INIT TERMINAL BATCH
+%token SET LOGFILE FORMAT JSON FACILITY DAEMON SYSLOG MAILSERVER HTTPD ALLOW REJECTOPT ADDRESS INIT TERMINAL BATCH
 %token READONLY CLEARTEXT MD5HASH SHA1HASH CRYPT DELAY
 %token PEMFILE ENABLE DISABLE SSL CIPHER CLIENTPEMFILE ALLOWSELFCERTIFICATION SELFSIGNED VERIFY CERTIFICATE CACERTIFICATEFILE CACERTIFICATEPATH VALID
 %token INTERFACE LINK PACKET BYTEIN BYTEOUT PACKETIN PACKETOUT SPEED SATURATION UPLOAD DOWNLOAD TOTAL
@@ -324,7 +337,7 @@ static void _setSSLOptions(SslOptions_T options);
 %token PIDFILE START STOP PATHTOK
 %token HOST HOSTNAME PORT IPV4 IPV6 TYPE UDP TCP TCPSSL PROTOCOL CONNECTION
 %token ALERT NOALERT MAILFORMAT UNIXSOCKET SIGNATURE
-%token TIMEOUT RETRY RESTART CHECKSUM EVERY NOTEVERY
+%token TIMEOUT RETRY RESTART CHECKSUM EVERY NOTEVERY ADAPTIVE SPREAD WATCHDOG ISOLATE
 %token DEFAULT HTTP HTTPS APACHESTATUS FTP SMTP SMTPS POP POPS IMAP IMAPS CLAMAV NNTP NTP3 MYSQL DNS WEBSOCKET
 %token SSH DWP LDAP2 LDAP3 RDATE RSYNC TNS PGSQL POSTFIXPOLICY SIP LMTP GPS RADIUS MEMCACHE REDIS MONGODB SIEVE SPAMASSASSIN FAIL2BAN
 %token <string> STRING PATH MAILADDR MAILFROM MAILREPLYTO MAILSUBJECT
@@ -337,6 +350,7 @@ static void _setSSLOptions(SslOptions_T options);
 %token THREADS CHILDREN METHOD GET HEAD STATUS ORIGIN VERSIONOPT READ WRITE OPERATION SERVICETIME DISK
 %token RESOURCE MEMORY TOTALMEMORY LOADAVG1 LOADAVG5 LOADAVG15 SWAP
 %token MODE ACTIVE PASSIVE MANUAL ONREBOOT NOSTART LASTSTATE CPU TOTALCPU CPUUSER CPUSYSTEM CPUWAIT
+%token CPUSTEAL CPUGUEST ANYCORE
 %token GROUP REQUEST DEPENDS BASEDIR SLOT EVENTQUEUE SECRET HOSTHEADER
 %token UID EUID GID MMONIT INSTANCE USERNAME PASSWORD
 %token TIME ATIME CTIME MTIME CHANGED MILLISECOND SECOND MINUTE HOUR DAY MONTH
@@ -367,6 +381,7 @@ statement_list  : statement
 statement       : setalert
                 | setssl
                 | setdaemon
+                | setwatchdog
                 | setterminal
                 | setlog
                 | seteventqueue
@@ -600,16 +615,52 @@ setalert        : SET alertmail formatlist reminder {
                   }
                 ;
 
-setdaemon       : SET DAEMON NUMBER startdelay {
+setdaemon       : SET DAEMON NUMBER startdelay spread {
                         if (! (Run.flags & Run_Daemon) || ihp.daemon) {
                                 ihp.daemon     = true;
                                 Run.flags      |= Run_Daemon;
                                 Run.polltime   = $3;
                                 Run.startdelay = $<number>4;
+                                if ($<number>5)
+                                        Run.flags |= Run_SpreadChecks;
+                                else
+                                        Run.flags &= ~Run_SpreadChecks;
                         }
                   }
                 ;
 
+spread          : /* EMPTY */ {
+                        $<number>$ = false;
+                  }
+                | SPREAD {
+                        $<number>$ = true;
+                  }
+                ;
+
+setwatchdog     : SET WATCHDOG watchdogtimeout isolate {
+                        Run.watchdog.timeout = $<number>3;
+                        Run.watchdog.isolate = $<number>4;
+                  }
+                ;
+
+watchdogtimeout : /* EMPTY */ {
+                        $<number>$ = WATCHDOG_TIMEOUT;
+                  }
+                | TIMEOUT NUMBER SECOND {
+                        if ($2 < 1)
+                                yyerror2("The watchdog timeout must be greater than zero");
+                        $<number>$ = $2;
+                  }
+                ;
+
+isolate         : /* EMPTY */ {
+                        $<number>$ = false;
+                  }
+                | ISOLATE {
+                        $<number>$ = true;
+                  }
+                ;
+
 setterminal     : SET TERMINAL BATCH {
                         Run.flags |= Run_Batch;
                   }
@@ -709,12 +760,41 @@ setlog          : SET LOGFILE PATH   {
                                 Run.flags |= Run_Log;
                         }
                   }
-                | SET LOGFILE SYSLOG {
+                | SET LOGFILE SYSLOG syslogserver {
                         setsyslog(NULL);
                   }
-                | SET LOGFILE SYSLOG FACILITY STRING {
+                | SET LOGFILE SYSLOG FACILITY STRING syslogserver {
                         setsyslog($5); FREE($5);
                   }
+                | SET LOGFILE FORMAT JSON {
+                        Run.flags |= Run_LogJson;
+                  }
+                ;
+
+syslogserver    : /* EMPTY */
+                | ADDRESS STRING syslogport syslogtype {
+                        FREE(Run.syslog.host);
+                        Run.syslog.host = $2;
+                  }
+                ;
+
+syslogport      : /* EMPTY */ {
+                        Run.syslog.port = PORT_SYSLOG;
+                  }
+                | PORT NUMBER {
+                        Run.syslog.port = $2;
+                  }
+                ;
+
+syslogtype      : /* EMPTY */ {
+                        Run.syslog.type = Socket_Udp;
+                  }
+                | TYPE UDP {
+                        Run.syslog.type = Socket_Udp;
+                  }
+                | TYPE TCP {
+                        Run.syslog.type = Socket_Tcp;
+                  }
                 ;
 
 seteventqueue   : SET EVENTQUEUE BASEDIR PATH {
@@ -1159,14 +1239,14 @@ checkproc       : CHECKPROC SERVICENAME PIDFILE PATH {
                         createservice(Service_Process, $<string>2, $4, check_process);
                         matchset.ignore = false;
                         matchset.match_path = NULL;
-                        matchset.match_string = Str_dup($4);
+                        matchset.match_string = Atom_string($4);
                         addmatch(&matchset, Action_Ignored, 0);
                   }
                 | CHECKPROC SERVICENAME MATCH PATH {
                         createservice(Service_Process, $<string>2, $4, check_process);
                         matchset.ignore = false;
                         matchset.match_path = NULL;
-                        matchset.match_string = Str_dup($4);
+                        matchset.match_string = Atom_string($4);
                         addmatch(&matchset, Action_Ignored, 0);
                   }
                 ;
@@ -1418,10 +1498,11 @@ icmpopt         : icmpcount
                 ;
 
 host            : /* EMPTY */ {
-                        portset.hostname = Str_dup(current->type == Service_Host ? current->path : LOCALHOST);
+                        portset.hostname = Atom_string(current->type == Service_Host ? current->path : LOCALHOST);
                   }
                 | HOST STRING {
-                        portset.hostname = $2;
+                        portset.hostname = Atom_string($2);
+                        FREE($2);
                   }
                 ;
 
@@ -2006,16 +2087,32 @@ every           : EVERY NUMBER CYCLE {
                         current->every.type = Every_SkipCycles;
                         current->every.spec.cycle.counter = current->every.spec.cycle.number = $2;
                  }
+                | EVERY NUMBER intervalunit adaptive {
+                        setinterval($2 * $<number>3, $<number>4);
+                 }
                 | EVERY TIMESPEC {
                         current->every.type = Every_Cron;
                         current->every.spec.cron = $2;
+                        if (! Time_cronCompile($2, &current->every.crontab))
+                                yyerror2("Invalid cron specification '%s'", $2);
                  }
                 | NOTEVERY TIMESPEC {
                         current->every.type = Every_NotInCron;
                         current->every.spec.cron = $2;
+                        if (! Time_cronCompile($2, &current->every.crontab))
+                                yyerror2("Invalid cron specification '%s'", $2);
                  }
                 ;
 
+intervalunit    : MILLISECOND { $<number>$ = 1; }
+                | SECOND      { $<number>$ = 1000; }
+                | MINUTE      { $<number>$ = 60000; }
+                ;
+
+adaptive        : /* EMPTY */ { $<number>$ = 0; }
+                | ADAPTIVE NUMBER intervalunit { $<number>$ = $2 * $<number>3; }
+                ;
+
 mode            : MODE ACTIVE {
                         current->mode = Monitor_Active;
                   }
@@ -2130,6 +2227,24 @@ resourcecpu     : resourcecpuid operator value PERCENT {
 resourcecpuid   : CPUUSER   { $<number>$ = Resource_CpuUser; }
                 | CPUSYSTEM { $<number>$ = Resource_CpuSystem; }
                 | CPUWAIT   { $<number>$ = Resource_CpuWait; }
+                | CPUSTEAL  {
+#ifndef HAVE_CPU_STEAL
+                        yywarning("cpu steal usage is not available on this platform");
+#endif
+                        $<number>$ = Resource_CpuSteal;
+                  }
+                | CPUGUEST  {
+#ifndef HAVE_CPU_STEAL
+                        yywarning("cpu guest usage is not available on this platform");
+#endif
+                        $<number>$ = Resource_CpuGuest;
+                  }
+                | ANYCORE   {
+#ifndef HAVE_CPU_CORE
+                        yywarning("cpu core usage is not available on this platform");
+#endif
+                        $<number>$ = Resource_CpuCore;
+                  }
                 | CPU       { $<number>$ = Resource_CpuPercent; }
                 ;
 
@@ -2572,7 +2687,8 @@ match           : IF CONTENT urloperator PATH rate1 THEN action1 {
                         matchset.not = $<number>3 == Operator_Equal ? false : true;
                         matchset.ignore = false;
                         matchset.match_path = NULL;
-                        matchset.match_string = $4;
+                        matchset.match_string = Atom_string($4);
+                        FREE($4);
                         addmatch(&matchset, $<number>7, 0);
                   }
                 | IGNORE CONTENT urloperator PATH {
@@ -2587,7 +2703,8 @@ match           : IF CONTENT urloperator PATH rate1 THEN action1 {
                         matchset.not = $<number>3 == Operator_Equal ? false : true;
                         matchset.ignore = true;
                         matchset.match_path = NULL;
-                        matchset.match_string = $4;
+                        matchset.match_string = Atom_string($4);
+                        FREE($4);
                         addmatch(&matchset, Action_Ignored, 0);
                   }
                 /* The below MATCH statement is deprecated (replaced by CONTENT) */
@@ -2601,7 +2718,8 @@ match           : IF CONTENT urloperator PATH rate1 THEN action1 {
                 | IF matchflagnot MATCH STRING rate1 THEN action1 {
                         matchset.ignore = false;
                         matchset.match_path = NULL;
-                        matchset.match_string = $4;
+                        matchset.match_string = Atom_string($4);
+                        FREE($4);
                         addmatch(&matchset, $<number>7, 0);
                   }
                 | IGNORE matchflagnot MATCH PATH {
@@ -2614,7 +2732,8 @@ match           : IF CONTENT urloperator PATH rate1 THEN action1 {
                 | IGNORE matchflagnot MATCH STRING {
                         matchset.ignore = true;
                         matchset.match_path = NULL;
-                        matchset.match_string = $4;
+                        matchset.match_string = Atom_string($4);
+                        FREE($4);
                         addmatch(&matchset, Action_Ignored, 0);
                   }
                 ;
@@ -2886,6 +3005,8 @@ boolean_t parse(char *controlfile) {
 
         servicelist = tail = current = NULL;
 
+        long long start = Time_monotonicMicro();
+
         if ((yyin = fopen(controlfile,"r")) == (FILE *)NULL) {
                 LogError("Cannot open the control file '%s' -- %s\n", controlfile, STRERROR);
                 return false;
@@ -2907,6 +3028,8 @@ boolean_t parse(char *controlfile) {
 
         FREE(currentfile);
 
+        Util_updateTiming(&Run.timing.parse, start);
+
         if (argyytext != NULL)
                 FREE(argyytext);
 
@@ -2937,6 +3060,10 @@ static void preparse() {
         arglineno                   = 1;
         argcurrentfile              = NULL;
         argyytext                   = NULL;
+        FREE(servicedigests);
+        servicedigests_count        = 0;
+        md5_init(&globaldigest);
+        currentdigest               = &globaldigest;
         /* Reset parser */
         Run.limits.sendExpectBuffer  = LIMIT_SENDEXPECTBUFFER;
         Run.limits.fileContentBuffer = LIMIT_FILECONTENTBUFFER;
@@ -2950,10 +3077,14 @@ static void preparse() {
         Run.onreboot                 = Onreboot_Start;
         Run.mmonitcredentials        = NULL;
         Run.httpd.flags              = Httpd_Disabled | Httpd_Signature;
+        Run.flags                   &= ~(Run_SpreadChecks | Run_LogJson);
+        Run.watchdog.timeout         = 0;
+        Run.watchdog.isolate         = false;
         Run.httpd.credentials        = NULL;
         memset(&(Run.httpd.socket), 0, sizeof(Run.httpd.socket));
         Run.mailserver_timeout       = SMTP_TIMEOUT;
         Run.eventlist_dir            = NULL;
+        Run.syslog.host              = NULL;
         Run.eventlist_slots          = -1;
         Run.system                   = NULL;
         Run.mmonits                  = NULL;
@@ -2963,6 +3094,11 @@ static void preparse() {
         Run.MailFormat.replyto       = NULL;
         Run.MailFormat.subject       = NULL;
         Run.MailFormat.message       = NULL;
+        /* The service and group name indexes, freed in gc() */
+        if (! servicetable)
+                servicetable = Table_new(0, Str_cmp, Str_hash);
+        if (! servicegrouptable)
+                servicegrouptable = Table_new(0, Str_cmp, Str_hash);
         depend_list                  = NULL;
         Run.flags |= Run_HandlerInit | Run_MmonitCredentials;
         for (int i = 0; i <= Handler_Max; i++)
@@ -3008,6 +3144,15 @@ static void postparse() {
         if (current)
                 addservice(current);
 
+        /* Finish the configuration digests, the check statements are in the same order as the services in the configuration */
+        int i = 0;
+        for (Service_T s = servicelist_conf; s && i < servicedigests_count; s = s->next_conf)
+                md5_finish(&servicedigests[i++], (md5_byte_t *)s->digest);
+        md5_finish(&globaldigest, (md5_byte_t *)Run.digest);
+        currentdigest = NULL;
+        FREE(servicedigests);
+        servicedigests_count = 0;
+
         /* Check that we do not start monit in daemon mode without having a poll time */
         if (! Run.polltime && ((Run.flags & Run_Daemon) || (Run.flags & Run_Foreground))) {
                 LogError("Poll time is invalid or not defined. Please define poll time in the control file\nas a number (> 0)  or use the -d option when starting monit\n");
@@ -3031,8 +3176,9 @@ static void postparse() {
                 Run.system = createservice(Service_System, Str_dup(hostname), NULL, check_system);
                 addservice(Run.system);
         }
-        addeventaction(&(Run.system->action_MONIT_START), Action_Start, Action_Ignored);
-        addeventaction(&(Run.system->action_MONIT_STOP), Action_Stop,  Action_Ignored);
+        _addeventaction(Run.system->arena, &(Run.system->action_MONIT_START), Action_Start, Action_Ignored);
+        _addeventaction(Run.system->arena, &(Run.system->action_MONIT_STOP), Action_Stop,  Action_Ignored);
+        _addeventaction(Run.system->arena, &(Run.system->action_MONIT_STALL), Action_Alert, Action_Alert);
 
         if (Run.mmonits) {
                 if (Run.httpd.flags & Httpd_Net) {
@@ -3062,6 +3208,7 @@ static void postparse() {
 #endif
 
         Processor_setHttpPostLimit();
+        Processor_flushCredentials();
 }
 
 
@@ -3093,26 +3240,29 @@ static Service_T createservice(Service_Type type, char *name, char *value, State
         if (current)
                 addservice(current);
 
-        NEW(current);
+        // The first arena chunk holds the service and its typical rules
+        Arena_T arena = Arena_new((int)sizeof(struct Service_T) + 1024);
+        ARENA_NEW(arena, current);
+        current->arena = arena;
         current->type = type;
         switch (type) {
                 case Service_Directory:
-                        NEW(current->inf.directory);
+                        NEWRULE(current->inf.directory);
                         break;
                 case Service_Fifo:
-                        NEW(current->inf.fifo);
+                        NEWRULE(current->inf.fifo);
                         break;
                 case Service_File:
-                        NEW(current->inf.file);
+                        NEWRULE(current->inf.file);
                         break;
                 case Service_Filesystem:
-                        NEW(current->inf.filesystem);
+                        NEWRULE(current->inf.filesystem);
                         break;
                 case Service_Net:
-                        NEW(current->inf.net);
+                        NEWRULE(current->inf.net);
                         break;
                 case Service_Process:
-                        NEW(current->inf.process);
+                        NEWRULE(current->inf.process);
                         break;
                 default:
                         break;
@@ -3120,7 +3270,7 @@ static Service_T createservice(Service_Type type, char *name, char *value, State
         Util_resetInfo(current);
 
         if (type == Service_Program) {
-                NEW(current->program);
+                NEWRULE(current->program);
                 current->program->args = command;
                 command = NULL;
                 current->program->timeout = Run.limits.programTimeout;
@@ -3218,6 +3368,8 @@ static void addservice(Service_T s) {
                         break;
         }
 
+        Table_put(servicetable, s->name, s);
+
         /* Add the service to the end of the service list */
         if (tail != NULL) {
                 tail->next = s;
@@ -3239,16 +3391,13 @@ static void addservicegroup(char *name) {
         ASSERT(name);
 
         /* Check if service group with the same name is defined already */
-        for (g = servicegrouplist; g; g = g->next)
-                if (IS(g->name, name))
-                        break;
-
-        if (! g) {
+        if (! (g = Table_get(servicegrouptable, name))) {
                 NEW(g);
-                g->name = Str_dup(name);
+                g->name = Atom_string(name);
                 g->members = List_new();
                 g->next = servicegrouplist;
                 servicegrouplist = g;
+                Table_put(servicegrouptable, g->name, g);
         }
 
         List_append(g->members, current);
@@ -3264,7 +3413,7 @@ static void adddependant(char *dependant) {
 
         ASSERT(dependant);
 
-        NEW(d);
+        NEWRULE(d);
 
         if (current->dependantlist)
                 d->next = current->dependantlist;
@@ -3285,7 +3434,8 @@ static void addmail(char *mailto, Mail_T f, Mail_T *l) {
         ASSERT(mailto);
 
         NEW(m);
-        m->to       = mailto;
+        m->to       = Atom_string(mailto);
+        FREE(mailto);
         m->from     = f->from;
         m->replyto  = f->replyto;
         m->subject  = f->subject;
@@ -3310,7 +3460,7 @@ static void addport(Port_T *list, Port_T port) {
                 yyerror("Radius protocol test supports UDP only");
 
         Port_T p;
-        NEW(p);
+        NEWRULE(p);
         p->is_available       = Connection_Init;
         p->type               = port->type;
         p->socket             = port->socket;
@@ -3392,7 +3542,7 @@ static void addresource(Resource_T rr) {
         ASSERT(rr);
         if (Run.flags & Run_ProcessEngineEnabled) {
                 Resource_T r;
-                NEW(r);
+                NEWRULE(r);
                 r->resource_id = rr->resource_id;
                 r->limit       = rr->limit;
                 r->action      = rr->action;
@@ -3413,7 +3563,7 @@ static void addtimestamp(Timestamp_T ts) {
         ASSERT(ts);
 
         Timestamp_T t;
-        NEW(t);
+        NEWRULE(t);
         t->type         = ts->type;
         t->operator     = ts->operator;
         t->time         = ts->time;
@@ -3440,7 +3590,7 @@ static void addactionrate(ActionRate_T ar) {
         if (ar->count <= 0 || ar->cycle <= 0)
                 yyerror2("Zero or negative values not allowed in a action rate statement");
 
-        NEW(a);
+        NEWRULE(a);
         a->count  = ar->count;
         a->cycle  = ar->cycle;
         a->action = ar->action;
@@ -3462,7 +3612,7 @@ static void addsize(Size_T ss) {
 
         ASSERT(ss);
 
-        NEW(s);
+        NEWRULE(s);
         s->operator     = ss->operator;
         s->size         = ss->size;
         s->action       = ss->action;
@@ -3489,7 +3639,7 @@ static void adduptime(Uptime_T uu) {
 
         ASSERT(uu);
 
-        NEW(u);
+        NEWRULE(u);
         u->operator = uu->operator;
         u->uptime = uu->uptime;
         u->action = uu->action;
@@ -3508,7 +3658,7 @@ static void addpid(Pid_T pp) {
         ASSERT(pp);
 
         Pid_T p;
-        NEW(p);
+        NEWRULE(p);
         p->action = pp->action;
 
         p->next = current->pidlist;
@@ -3525,7 +3675,7 @@ static void addppid(Pid_T pp) {
         ASSERT(pp);
 
         Pid_T p;
-        NEW(p);
+        NEWRULE(p);
         p->action = pp->action;
 
         p->next = current->ppidlist;
@@ -3542,7 +3692,7 @@ static void addfsflag(FsFlag_T ff) {
         ASSERT(ff);
 
         FsFlag_T f;
-        NEW(f);
+        NEWRULE(f);
         f->action = ff->action;
 
         f->next = current->fsflaglist;
@@ -3559,7 +3709,7 @@ static void addnonexist(NonExist_T ff) {
         ASSERT(ff);
 
         NonExist_T f;
-        NEW(f);
+        NEWRULE(f);
         f->action = ff->action;
 
         f->next = current->nonexistlist;
@@ -3572,7 +3722,7 @@ static void addnonexist(NonExist_T ff) {
 static void addexist(Exist_T rule) {
         ASSERT(rule);
         Exist_T r;
-        NEW(r);
+        NEWRULE(r);
         r->action = rule->action;
         r->next = current->existlist;
         current->existlist = r;
@@ -3617,7 +3767,7 @@ static void addchecksum(Checksum_T cs) {
         }
 
         Checksum_T c;
-        NEW(c);
+        NEWRULE(c);
         c->type         = cs->type;
         c->test_changes = cs->test_changes;
         c->initialized  = cs->initialized;
@@ -3638,7 +3788,7 @@ static void addperm(Perm_T ps) {
         ASSERT(ps);
 
         Perm_T p;
-        NEW(p);
+        NEWRULE(p);
         p->action = ps->action;
         p->test_changes = ps->test_changes;
         if (p->test_changes) {
@@ -3660,7 +3810,7 @@ static void addlinkstatus(Service_T s, LinkStatus_T L) {
         ASSERT(L);
         
         LinkStatus_T l;
-        NEW(l);
+        ARENA_NEW(s->arena, l);
         l->action = L->action;
         
         l->next = s->linkstatuslist;
@@ -3674,7 +3824,7 @@ static void addlinkspeed(Service_T s, LinkSpeed_T L) {
         ASSERT(L);
         
         LinkSpeed_T l;
-        NEW(l);
+        ARENA_NEW(s->arena, l);
         l->action = L->action;
         
         l->next = s->linkspeedlist;
@@ -3688,7 +3838,7 @@ static void addlinksaturation(Service_T s, LinkSaturation_T L) {
         ASSERT(L);
         
         LinkSaturation_T l;
-        NEW(l);
+        ARENA_NEW(s->arena, l);
         l->operator = L->operator;
         l->limit = L->limit;
         l->action = L->action;
@@ -3722,7 +3872,7 @@ static void addbandwidth(Bandwidth_T *list, Bandwidth_T b) {
                         b->range = Time_Hour;
                 }
                 Bandwidth_T bandwidth;
-                NEW(bandwidth);
+                NEWRULE(bandwidth);
                 bandwidth->operator = b->operator;
                 bandwidth->limit = b->limit;
                 bandwidth->rangecount = b->rangecount;
@@ -3756,8 +3906,8 @@ static void addmatch(Match_T ms, int actionnumber, int linenumber) {
 
         ASSERT(ms);
 
-        NEW(m);
-        NEW(m->regex_comp);
+        NEWRULE(m);
+        NEWRULE(m->regex_comp);
 
         m->match_string = ms->match_string;
         m->match_path   = ms->match_path ? Str_dup(ms->match_path) : NULL;
@@ -3813,7 +3963,7 @@ static void addmatchpath(Match_T ms, Action_Type actionnumber) {
                 if (buf[len-1] == '\n')
                         buf[len-1] = 0;
 
-                ms->match_string = Str_dup(buf);
+                ms->match_string = Atom_string(buf);
 
                 /* The addeventaction() called from addmatch() will reset the
                  * command1 to NULL, but we need to duplicate the command for
@@ -3842,7 +3992,7 @@ static void addmatchpath(Match_T ms, Action_Type actionnumber) {
 static void addstatus(Status_T status) {
         Status_T s;
         ASSERT(status);
-        NEW(s);
+        NEWRULE(s);
         s->initialized = status->initialized;
         s->return_value = status->return_value;
         s->operator = status->operator;
@@ -3861,7 +4011,7 @@ static Uid_T adduid(Uid_T u) {
         ASSERT(u);
 
         Uid_T uid;
-        NEW(uid);
+        NEWRULE(uid);
         uid->uid = u->uid;
         uid->action = u->action;
         reset_uidset();
@@ -3876,7 +4026,7 @@ static Gid_T addgid(Gid_T g) {
         ASSERT(g);
 
         Gid_T gid;
-        NEW(gid);
+        NEWRULE(gid);
         gid->gid = g->gid;
         gid->action = g->action;
         reset_gidset();
@@ -3892,7 +4042,7 @@ static void addfilesystem(FileSystem_T ds) {
 
         ASSERT(ds);
 
-        NEW(dev);
+        NEWRULE(dev);
         dev->resource           = ds->resource;
         dev->operator           = ds->operator;
         dev->limit_absolute     = ds->limit_absolute;
@@ -3915,7 +4065,7 @@ static void addicmp(Icmp_T is) {
 
         ASSERT(is);
 
-        NEW(icmp);
+        NEWRULE(icmp);
         icmp->family       = is->family;
         icmp->type         = is->type;
         icmp->size         = is->size;
@@ -3934,16 +4084,40 @@ static void addicmp(Icmp_T is) {
 
 
 /*
- * Set EventAction object
+ * Set EventAction object of the current service
  */
 static void addeventaction(EventAction_T *_ea, Action_Type failed, Action_Type succeeded) {
+        _addeventaction(current->arena, _ea, failed, succeeded);
+}
+
+
+/*
+ * Move the command to the arena, the command reference is set to NULL
+ */
+static command_t _arenacommand(Arena_T arena, command_t *command) {
+        command_t c;
+        ARENA_NEW(arena, c);
+        *c = **command;
+        for (int i = 0; i < c->length; i++) {
+                long n = (long)strlen((*command)->arg[i]) + 1;
+                c->arg[i] = memcpy(Arena_alloc(arena, n, __func__, __FILE__, __LINE__), (*command)->arg[i], n);
+        }
+        gccmd(command);
+        return c;
+}
+
+
+/*
+ * Set EventAction object allocated from the given service arena
+ */
+static void _addeventaction(Arena_T arena, EventAction_T *_ea, Action_Type failed, Action_Type succeeded) {
         EventAction_T ea;
 
         ASSERT(_ea);
 
-        NEW(ea);
-        NEW(ea->failed);
-        NEW(ea->succeeded);
+        ARENA_NEW(arena, ea);
+        ARENA_NEW(arena, ea->failed);
+        ARENA_NEW(arena, ea->succeeded);
 
         ea->failed->id = failed;
         ea->failed->repeat = repeat1;
@@ -3951,8 +4125,7 @@ static void addeventaction(EventAction_T *_ea, Action_Type failed, Action_Type s
         ea->failed->cycles = rate1.cycles;
         if (failed == Action_Exec) {
                 ASSERT(command1);
-                ea->failed->exec = command1;
-                command1 = NULL;
+                ea->failed->exec = _arenacommand(arena, &command1);
         }
 
         ea->succeeded->id = succeeded;
@@ -3961,8 +4134,7 @@ static void addeventaction(EventAction_T *_ea, Action_Type failed, Action_Type s
         ea->succeeded->cycles = rate2.cycles;
         if (succeeded == Action_Exec) {
                 ASSERT(command2);
-                ea->succeeded->exec = command2;
-                command2 = NULL;
+                ea->succeeded->exec = _arenacommand(arena, &command2);
         }
         *_ea = ea;
         reset_rateset(&rate);
@@ -4059,7 +4231,7 @@ static void prepare_urlrequest(URL_T U) {
         if (urlrequest == NULL)
                 NEW(urlrequest);
         urlrequest->url = U;
-        portset.hostname = Str_dup(U->hostname);
+        portset.hostname = Atom_string(U->hostname);
         portset.target.net.port = U->port;
         portset.url_request = urlrequest;
         portset.type = Socket_Tcp;
@@ -4268,6 +4440,24 @@ static void setpidfile(char *pidfile) {
 }
 
 
+/*
+ * Set the millisecond check interval of the current service. If max is
+ * set, the interval is adaptive: it grows up to max while the service is
+ * stable
+ */
+static void setinterval(int interval, int max) {
+        if (interval < 1)
+                yyerror2("The check interval must be greater than zero");
+        if (max && max <= interval)
+                yyerror2("The adaptive check interval maximum must be greater than the check interval");
+        current->every.type = Every_Interval;
+        current->every.spec.interval.base = current->every.spec.interval.current = interval;
+        current->every.spec.interval.max = max;
+        current->every.spec.interval.nearLimit = false;
+        current->every.next = 0LL;
+}
+
+
 /*
  * Read a apache htpasswd file and add credentials found for username
  */
@@ -207,7 +207,9 @@ int ProcessTree_init(ProcessEngine_Flags pflags) {
                 }
         }
 
-        systeminfo.time_prev = systeminfo.time;
+        // The CPU usage delta is based on the monotonic clock, so it is correct for sub-second intervals and not affected by system time changes
+        long long monotonic_prev = systeminfo.monotonic;
+        systeminfo.monotonic = Time_monotonic();
         systeminfo.time = Time_milli() / 100.;
         if ((ptreesize = initprocesstree_sysdep(&ptree, pflags)) <= 0 || ! ptree) {
                 DEBUG("System statistic -- cannot initialize the process tree -- process resource monitoring disabled\n");
@@ -222,7 +224,7 @@ int ProcessTree_init(ProcessEngine_Flags pflags) {
 
         int root = -1; // Main process. Not all systems have main process with PID 1 (such as Solaris zones and FreeBSD jails), so we try to find process which is parent of itself
         ProcessTree_T *pt = ptree;
-        double time_delta = systeminfo.time - systeminfo.time_prev;
+        double time_delta = monotonic_prev ? (systeminfo.monotonic - monotonic_prev) / 100. : 0.;
         for (int i = 0; i < (volatile int)ptreesize; i ++) {
                 if (oldptree) {
                         int oldentry = _findProcess(pt[i].pid, oldptree, oldptreesize);
@@ -453,6 +455,11 @@ boolean_t init_system_info(void) {
         systeminfo.cpu.usage.user = -1.;
         systeminfo.cpu.usage.system = -1.;
         systeminfo.cpu.usage.wait = -1.;
+        systeminfo.cpu.usage.steal = -1.;
+        systeminfo.cpu.usage.guest = -1.;
+        systeminfo.cpu.usage.irq = -1.;
+        systeminfo.cpu.usage.softirq = -1.;
+        systeminfo.cpu.core.max = -1.;
         return (init_process_info_sysdep());
 }
 
@@ -493,6 +500,12 @@ error3:
         systeminfo.cpu.usage.user = 0.;
         systeminfo.cpu.usage.system = 0.;
         systeminfo.cpu.usage.wait = 0.;
+        systeminfo.cpu.usage.steal = 0.;
+        systeminfo.cpu.usage.guest = 0.;
+        systeminfo.cpu.usage.irq = 0.;
+        systeminfo.cpu.usage.softirq = 0.;
+        systeminfo.cpu.core.count = 0;
+        systeminfo.cpu.core.max = 0.;
 
         return false;
 }
@@ -79,6 +79,7 @@
 
 // libmonit
 #include "system/Time.h"
+#include "io/FileCache.h"
 
 /**
  *  System dependent resource data collection code for Linux.
@@ -109,10 +110,27 @@ static void __attribute__ ((constructor)) _constructor() {
 
 #define NSEC_PER_SEC    1000000000L
 
-static unsigned long long old_cpu_user     = 0;
-static unsigned long long old_cpu_syst     = 0;
-static unsigned long long old_cpu_wait     = 0;
-static unsigned long long old_cpu_total    = 0;
+/* Ticks of one "cpu" line in /proc/stat. The guest times are already included in user and nice by the kernel */
+typedef struct CpuTicks_T {
+        unsigned long long user;
+        unsigned long long nice;
+        unsigned long long system;
+        unsigned long long idle;
+        unsigned long long iowait;
+        unsigned long long irq;
+        unsigned long long softirq;
+        unsigned long long steal;
+        unsigned long long guest;
+        unsigned long long guest_nice;
+} CpuTicks_T;
+
+static struct {
+        char *buf;                                                  /* Read buffer */
+        size_t size;                                           /* Read buffer size */
+        int cores;                               /* Number of per-core tick slots */
+        CpuTicks_T total;                               /* Last aggregate ticks */
+        CpuTicks_T *core;                                /* Last per-core ticks */
+} _procstat = {};
 
 static long page_size = 0;
 
@@ -132,6 +150,45 @@ static time_t get_starttime() {
 }
 
 
+static unsigned long long _ticksTotal(CpuTicks_T *t) {
+        return t->user + t->nice + t->system + t->idle + t->iowait + t->irq + t->softirq + t->steal;
+}
+
+
+static double _ticksDelta(unsigned long long now, unsigned long long old) {
+        return now > old ? (double)(now - old) : 0.;
+}
+
+
+/**
+ * Read /proc/stat into _procstat.buf. The descriptor is kept open in FileCache
+ * across cycles. The buffer grows until it holds all "cpu" lines.
+ * @return true if succeeded otherwise false
+ */
+static boolean_t _readProcStat() {
+        if (! _procstat.buf) {
+                _procstat.size = (systeminfo.cpu.count + 2) * STRLEN;
+                _procstat.buf = ALLOC(_procstat.size);
+        }
+        ssize_t n;
+        while ((n = FileCache_read("/proc/stat", _procstat.buf, _procstat.size)) == (ssize_t)_procstat.size - 1) {
+                // All cpu lines were read if we have a complete line which is not a cpu line
+                char *line = _procstat.buf, *eol;
+                while ((eol = strchr(line, '\n')) && Str_startsWith(line, "cpu"))
+                        line = eol + 1;
+                if (eol)
+                        break;
+                _procstat.size *= 2;
+                RESIZE(_procstat.buf, _procstat.size);
+        }
+        if (n < 0) {
+                DEBUG("system statistic error -- cannot read /proc/stat -- %s\n", STRERROR);
+                return false;
+        }
+        return true;
+}
+
+
 /* ------------------------------------------------------------------ Public */
 
 
@@ -402,15 +459,12 @@ boolean_t used_system_memory_sysdep(SystemInfo_T *si) {
                 DEBUG("system statistic error -- cannot get real memory cache amount\n");
         if (! (ptr = strstr(buf, "SReclaimable:")) || sscanf(ptr + 13, "%ld", &slabreclaimable) != 1)
                 DEBUG("system statistic error -- cannot get slab reclaimable memory amount\n");
-        FILE *f = fopen("/proc/spl/kstat/zfs/arcstats", "r");
-        if (f) {
-                char line[STRLEN];
-                while (fgets(line, sizeof(line), f)) {
-                        if (sscanf(line, "size %*d %"PRIu64, &zfsarcsize) == 1) {
-                                break;
-                        }
-                }
-                fclose(f);
+        static char *arcstats = NULL;
+        static size_t arcstatsSize = 0;
+        if (FileCache_readAll("/proc/spl/kstat/zfs/arcstats", &arcstats, &arcstatsSize) > 0) {
+                char *ptr = strstr(arcstats, "\nsize ");
+                if (ptr)
+                        sscanf(ptr + 1, "size %*d %"PRIu64, &zfsarcsize);
         }
         si->memory.usage.bytes = systeminfo.memory.size - zfsarcsize - (uint64_t)(mem_free + buffers + cached + slabreclaimable) * 1024;
 
@@ -436,70 +490,93 @@ error:
 
 
 /**
- * This routine returns system/user CPU time in use.
+ * This routine returns system/user CPU time in use. All lines of /proc/stat
+ * starting with "cpu" are parsed: the aggregate line is used for the system
+ * totals, the per-core lines for the single core usage.
  * @return: true if successful, false if failed (or not available)
  */
 boolean_t used_system_cpu_sysdep(SystemInfo_T *si) {
-        boolean_t rv;
-        unsigned long long cpu_total;
-        unsigned long long cpu_user;
-        unsigned long long cpu_nice;
-        unsigned long long cpu_syst;
-        unsigned long long cpu_idle;
-        unsigned long long cpu_wait;
-        unsigned long long cpu_irq;
-        unsigned long long cpu_softirq;
-        char buf[STRLEN];
-
-        if (! file_readProc(buf, sizeof(buf), "stat", -1, NULL)) {
+        if (! _readProcStat()) {
                 LogError("system statistic error -- cannot read /proc/stat\n");
                 goto error;
         }
 
-        rv = sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu",
-                    &cpu_user,
-                    &cpu_nice,
-                    &cpu_syst,
-                    &cpu_idle,
-                    &cpu_wait,
-                    &cpu_irq,
-                    &cpu_softirq);
-        if (rv < 4) {
-                LogError("system statistic error -- cannot read cpu usage\n");
-                goto error;
-        } else if (rv == 4) {
-                /* linux 2.4.x doesn't support these values */
-                cpu_wait    = 0;
-                cpu_irq     = 0;
-                cpu_softirq = 0;
+        if (! _procstat.core) {
+                _procstat.cores = systeminfo.cpu.count;
+                _procstat.core = CALLOC(_procstat.cores, sizeof(CpuTicks_T));
+                si->cpu.core.sample = CALLOC(_procstat.cores, sizeof(*si->cpu.core.sample));
         }
 
-        cpu_total = cpu_user + cpu_nice + cpu_syst + cpu_idle + cpu_wait + cpu_irq + cpu_softirq;
-        cpu_user  = cpu_user + cpu_nice;
+        boolean_t initialized = _procstat.total.user || _procstat.total.idle;
+        CpuTicks_T total = {};
+        si->cpu.core.count = 0;
+        si->cpu.core.max = initialized ? 0. : -1.;
+        for (char *line = _procstat.buf, *eol; line && Str_startsWith(line, "cpu"); line = eol ? eol + 1 : NULL) {
+                eol = strchr(line, '\n');
+                int id = -1;
+                CpuTicks_T t = {};
+                int rv;
+                if (line[3] == ' ')
+                        rv = sscanf(line + 3, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", &t.user, &t.nice, &t.system, &t.idle, &t.iowait, &t.irq, &t.softirq, &t.steal, &t.guest, &t.guest_nice);
+                else if (sscanf(line + 3, "%d%n", &id, &rv) == 1 && id >= 0)
+                        rv = sscanf(line + 3 + rv, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", &t.user, &t.nice, &t.system, &t.idle, &t.iowait, &t.irq, &t.softirq, &t.steal, &t.guest, &t.guest_nice);
+                else
+                        continue;
+                if (rv < 4) {
+                        LogError("system statistic error -- cannot read cpu usage\n");
+                        goto error;
+                }
+                if (id < 0) {
+                        total = t;
+                } else if (id < _procstat.cores) {
+                        // Cores may go offline => compute usage only if the core was present in the last cycle too
+                        CpuTicks_T *old = &_procstat.core[id];
+                        double delta = _ticksDelta(_ticksTotal(&t), _ticksTotal(old));
+                        if (initialized && delta > 0. && (old->user || old->idle)) {
+                                float usage = 100. * (1. - (_ticksDelta(t.idle, old->idle) + _ticksDelta(t.iowait, old->iowait)) / delta);
+                                // The samples are compact, offline cores are left out => keep the core id with the usage
+                                si->cpu.core.sample[si->cpu.core.count].id = id;
+                                si->cpu.core.sample[si->cpu.core.count++].usage = usage;
+                                if (usage > si->cpu.core.max)
+                                        si->cpu.core.max = usage;
+                        }
+                        *old = t;
+                }
+        }
 
-        if (old_cpu_total == 0) {
+        if (! initialized) {
                 si->cpu.usage.user = -1.;
                 si->cpu.usage.system = -1.;
                 si->cpu.usage.wait = -1.;
+                si->cpu.usage.steal = -1.;
+                si->cpu.usage.guest = -1.;
+                si->cpu.usage.irq = -1.;
+                si->cpu.usage.softirq = -1.;
         } else {
-                unsigned long long delta = cpu_total - old_cpu_total;
-
-                si->cpu.usage.user = 100. * (double)(cpu_user - old_cpu_user) / delta;
-                si->cpu.usage.system = 100. * (double)(cpu_syst - old_cpu_syst) / delta;
-                si->cpu.usage.wait = 100. * (double)(cpu_wait - old_cpu_wait) / delta;
+                double delta = _ticksDelta(_ticksTotal(&total), _ticksTotal(&_procstat.total));
+                if (delta > 0.) {
+                        CpuTicks_T *old = &_procstat.total;
+                        si->cpu.usage.user = 100. * (_ticksDelta(total.user, old->user) + _ticksDelta(total.nice, old->nice)) / delta;
+                        si->cpu.usage.system = 100. * _ticksDelta(total.system, old->system) / delta;
+                        si->cpu.usage.wait = 100. * _ticksDelta(total.iowait, old->iowait) / delta;
+                        si->cpu.usage.steal = 100. * _ticksDelta(total.steal, old->steal) / delta;
+                        si->cpu.usage.guest = 100. * (_ticksDelta(total.guest, old->guest) + _ticksDelta(total.guest_nice, old->guest_nice)) / delta;
+                        si->cpu.usage.irq = 100. * _ticksDelta(total.irq, old->irq) / delta;
+                        si->cpu.usage.softirq = 100. * _ticksDelta(total.softirq, old->softirq) / delta;
+                }
         }
-
-        old_cpu_user  = cpu_user;
-        old_cpu_syst  = cpu_syst;
-        old_cpu_wait  = cpu_wait;
-        old_cpu_total = cpu_total;
+        _procstat.total = total;
         return true;
 
 error:
         si->cpu.usage.user = 0.;
         si->cpu.usage.system = 0.;
         si->cpu.usage.wait = 0.;
+        si->cpu.usage.steal = 0.;
+        si->cpu.usage.guest = 0.;
+        si->cpu.usage.irq = 0.;
+        si->cpu.usage.softirq = 0.;
+        si->cpu.core.count = 0;
+        si->cpu.core.max = 0.;
         return false;
 }
-
-
@@ -72,6 +72,10 @@
 #include <netdb.h>
 #endif
 
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 #include "net.h"
 #include "monit.h"
 #include "socket.h"
@@ -104,6 +108,8 @@ typedef enum {
 
 // One TCP frame data size
 #define RBUFFER_SIZE 1460
+// Maximum TLS record payload, smaller gather writes are coalesced into one record
+#define WBUFFER_SIZE 16384
 
 
 #define T Socket_T
@@ -705,6 +711,55 @@ int Socket_write(T S, void *b, size_t size) {
 }
 
 
+int Socket_writev(T S, struct iovec *iov, int count) {
+        ASSERT(S);
+        ASSERT(iov);
+        size_t total = 0;
+        for (int i = 0; i < count; i++)
+                total += iov[i].iov_len;
+#ifdef HAVE_OPENSSL
+        if (S->ssl) {
+                if (total <= WBUFFER_SIZE) {
+                        unsigned char buffer[WBUFFER_SIZE];
+                        size_t length = 0;
+                        for (int i = 0; i < count; i++) {
+                                memcpy(buffer + length, iov[i].iov_base, iov[i].iov_len);
+                                length += iov[i].iov_len;
+                        }
+                        return Socket_write(S, buffer, length);
+                }
+                for (int i = 0; i < count; i++)
+                        if (Socket_write(S, iov[i].iov_base, iov[i].iov_len) < 0)
+                                return -1;
+                return (int)total;
+        }
+#endif
+        size_t written = 0;
+        for (int i = 0; i < count;) {
+                ssize_t n;
+                do {
+                        n = writev(S->socket, iov + i, count - i);
+                } while (n == -1 && errno == EINTR);
+                if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                        if (S->timeout == 0 || ! Net_canWrite(S->socket, S->timeout))
+                                return -1;
+                        continue;
+                }
+                if (n < 0)
+                        return -1;
+                written += n;
+                // Skip the vectors written completely and advance a partially written one
+                for (; i < count && (size_t)n >= iov[i].iov_len; i++)
+                        n -= iov[i].iov_len;
+                if (i < count) {
+                        iov[i].iov_base = (char *)iov[i].iov_base + n;
+                        iov[i].iov_len -= n;
+                }
+        }
+        return (int)written;
+}
+
+
 int Socket_readByte(T S) {
         ASSERT(S);
         if (S->offset >= S->length)
@@ -51,6 +51,7 @@ typedef enum {
 
 #define T Socket_T
 typedef struct T *T;
+struct iovec;
 
 
 /**
@@ -242,6 +243,19 @@ int Socket_print(T S, const char *m, ...) __attribute__((format (printf, 2, 3)))
 int Socket_write(T S, void *b, size_t size);
 
 
+/**
+ * Write the data described by the iovec array with one gather write
+ * if possible. SSL connections have no gather write; small data is
+ * coalesced into one buffer so it is sent in one TLS record. The
+ * iovec array is modified if a partial write occurs.
+ * @param S A Socket_T object
+ * @param iov The data to be written
+ * @param count The number of elements in iov
+ * @return The bytes sent or -1 if an error occurred
+ */
+int Socket_writev(T S, struct iovec *iov, int count);
+
+
 /**
  * Read a single byte. The byte is returned as an int in the range 0
  * to 255.
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+#include "config.h"
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+
+#include "monit.h"
+#include "socket.h"
+#include "syslogger.h"
+
+// libmonit
+#include "system/Time.h"
+#include "exceptions/AssertException.h"
+
+
+/**
+ * Implementation of the syslog client, see syslogger.h
+ *
+ * @file
+ */
+
+
+/* ------------------------------------------------------------- Definitions */
+
+
+#define SYSLOG_QUEUE   1024                                    /* Queued messages */
+#define SYSLOG_MESSAGE 1024         /* Message length limit, longer messages are truncated */
+#define SYSLOG_HEADER  320         /* Octet count and RFC 5424 header length limit */
+#define SYSLOG_BATCH   64                                /* Messages sent at once */
+#define SYSLOG_BACKOFF 64                         /* Maximum reconnect delay [s] */
+
+
+typedef struct SyslogRecord_T {
+        int priority;
+        int length;
+        time_t time;
+        char message[SYSLOG_MESSAGE];
+} *SyslogRecord_T;
+
+
+static struct {
+        boolean_t initialized;
+        boolean_t running;
+        int head;                                     /**< Next free queue slot */
+        int count;                                /**< Number of queued messages */
+        int backoff;                                 /**< Reconnect delay [s] */
+        time_t retry;                     /**< Don't reconnect before this time */
+        struct {
+                char *host;
+                int port;
+                Socket_Type type;
+        } server;                       /**< Copy of the Run.syslog settings */
+        char hostname[256];
+        Socket_T socket;
+        Thread_T thread;
+        Sem_T cond;
+        Mutex_T mutex;
+        SyslogRecord_T queue;
+        struct {
+                int length[SYSLOG_BATCH];
+                char *buffer;
+        } batch;                               /**< The frames being sent */
+} _syslogger = {};
+
+
+/* ----------------------------------------------------------------- Private */
+
+
+/**
+ * Format up to SYSLOG_BATCH oldest queued messages as RFC 5424 frames. The
+ * messages are removed from the queue only after they were sent, so the
+ * producers don't reuse their slots meanwhile. Must be called locked
+ * @return The number of the formatted messages
+ */
+static int _frame() {
+        int count = _syslogger.count < SYSLOG_BATCH ? _syslogger.count : SYSLOG_BATCH;
+        int tail = (_syslogger.head - _syslogger.count + SYSLOG_QUEUE) % SYSLOG_QUEUE;
+        char *p = _syslogger.batch.buffer;
+        for (int i = 0; i < count; i++) {
+                SyslogRecord_T r = &_syslogger.queue[(tail + i) % SYSLOG_QUEUE];
+                char header[SYSLOG_HEADER], timestamp[32];
+                struct tm t;
+                gmtime_r(&r->time, &t);
+                strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &t);
+                int length = snprintf(header, sizeof(header), "<%d>1 %s %s %s %d - - ", Run.facility | r->priority, timestamp, _syslogger.hostname, prog, (int)getpid());
+                if (length >= (int)sizeof(header))
+                        length = sizeof(header) - 1;
+                char *frame = p;
+                // RFC 6587 octet counting: the frame length precedes the message on the TCP stream, the UDP datagram holds the message alone
+                if (_syslogger.server.type == Socket_Tcp)
+                        p += sprintf(p, "%d ", length + r->length);
+                memcpy(p, header, length);
+                p += length;
+                memcpy(p, r->message, r->length);
+                p += r->length;
+                _syslogger.batch.length[i] = (int)(p - frame);
+        }
+        return count;
+}
+
+
+/**
+ * Send the formatted frames, the TCP frames are written at once
+ * @return true if the frames were sent, otherwise false
+ */
+static boolean_t _deliver(int count) {
+        if (! _syslogger.socket) {
+                if (Time_now() < _syslogger.retry)
+                        return false;
+                if (! (_syslogger.socket = Socket_new(_syslogger.server.host, _syslogger.server.port, _syslogger.server.type, Socket_Ip, SSL_Disabled, Run.limits.networkTimeout))) {
+                        Run.timing.syslogerrors++;
+                        _syslogger.backoff = _syslogger.backoff ? (_syslogger.backoff * 2 < SYSLOG_BACKOFF ? _syslogger.backoff * 2 : SYSLOG_BACKOFF) : 1;
+                        _syslogger.retry = Time_now() + _syslogger.backoff;
+                        return false;
+                }
+                if (_syslogger.backoff)
+                        LogInfo("Syslog server [%s]:%d connected\n", _syslogger.server.host, _syslogger.server.port);
+                _syslogger.backoff = 0;
+        }
+        char *p = _syslogger.batch.buffer;
+        if (_syslogger.server.type == Socket_Tcp) {
+                int length = 0;
+                for (int i = 0; i < count; i++)
+                        length += _syslogger.batch.length[i];
+                if (Socket_write(_syslogger.socket, p, length) < 0)
+                        goto error;
+        } else {
+                for (int i = 0; i < count; p += _syslogger.batch.length[i++])
+                        if (Socket_write(_syslogger.socket, p, _syslogger.batch.length[i]) < 0)
+                                goto error;
+        }
+        return true;
+error:
+        LogError("Syslog server [%s]:%d write error -- %s\n", _syslogger.server.host, _syslogger.server.port, STRERROR);
+        Run.timing.syslogerrors++;
+        Socket_free(&_syslogger.socket);
+        _syslogger.backoff = 1;
+        _syslogger.retry = Time_now() + _syslogger.backoff;
+        return false;
+}
+
+
+static void *_sender(void *args) {
+        set_signal_block();
+        while (true) {
+                int count = 0;
+                LOCK(_syslogger.mutex)
+                {
+                        // Wait for the messages, or for the reconnect time if the server is not reachable
+                        while (_syslogger.running && (! _syslogger.count || (! _syslogger.socket && Time_now() < _syslogger.retry))) {
+                                struct timespec wait = {.tv_sec = Time_now() + 1, .tv_nsec = 0};
+                                Sem_timeWait(_syslogger.cond, _syslogger.mutex, wait);
+                        }
+                        count = _frame();
+                }
+                END_LOCK;
+                if (! count)
+                        break;
+                boolean_t sent = _deliver(count);
+                LOCK(_syslogger.mutex)
+                {
+                        if (sent) {
+                                _syslogger.count -= count;
+                                Run.timing.syslogsent += count;
+                        } else if (! _syslogger.running) {
+                                // Stopping and the server is not reachable
+                                Run.timing.syslogdropped += _syslogger.count;
+                                _syslogger.count = 0;
+                        }
+                }
+                END_LOCK;
+        }
+        if (_syslogger.socket)
+                Socket_free(&_syslogger.socket);
+        return NULL;
+}
+
+
+/* ------------------------------------------------------------------ Public */
+
+
+void Syslogger_start() {
+        if (Run.syslog.host && (Run.flags & Run_UseSyslog) && ! _syslogger.running) {
+                // The queue and the lock are kept for the process lifetime, a thread which logs while the sender is stopping may still use them
+                if (! _syslogger.initialized) {
+                        _syslogger.queue = CALLOC(SYSLOG_QUEUE, sizeof(*_syslogger.queue));
+                        _syslogger.batch.buffer = ALLOC(SYSLOG_BATCH * (SYSLOG_HEADER + SYSLOG_MESSAGE));
+                        Mutex_init(_syslogger.mutex);
+                        Sem_init(_syslogger.cond);
+                        _syslogger.initialized = true;
+                }
+                LOCK(_syslogger.mutex)
+                {
+                        FREE(_syslogger.server.host);
+                        _syslogger.server.host = Str_dup(Run.syslog.host);
+                        _syslogger.server.port = Run.syslog.port;
+                        _syslogger.server.type = Run.syslog.type;
+                        if (gethostname(_syslogger.hostname, sizeof(_syslogger.hostname)) || ! *_syslogger.hostname)
+                                snprintf(_syslogger.hostname, sizeof(_syslogger.hostname), "-");
+                        _syslogger.hostname[sizeof(_syslogger.hostname) - 1] = 0;
+                        _syslogger.head = _syslogger.count = _syslogger.backoff = 0;
+                        _syslogger.retry = 0;
+                        _syslogger.running = true;
+                }
+                END_LOCK;
+                Thread_create(_syslogger.thread, _sender, NULL);
+        }
+}
+
+
+void Syslogger_stop() {
+        if (_syslogger.initialized) {
+                boolean_t running = false;
+                LOCK(_syslogger.mutex)
+                {
+                        running = _syslogger.running;
+                        _syslogger.running = false;
+                        Sem_signal(_syslogger.cond);
+                }
+                END_LOCK;
+                if (running)
+                        Thread_join(_syslogger.thread);
+        }
+}
+
+
+boolean_t Syslogger_send(int priority, time_t time, const char *message, int length) {
+        ASSERT(message);
+        boolean_t queued = false;
+        if (_syslogger.initialized) {
+                while (length > 0 && (message[length - 1] == '\n' || message[length - 1] == '\r'))
+                        length--;
+                if (length > SYSLOG_MESSAGE)
+                        length = SYSLOG_MESSAGE;
+                LOCK(_syslogger.mutex)
+                {
+                        if (_syslogger.running) {
+                                queued = true;
+                                if (_syslogger.count == SYSLOG_QUEUE) {
+                                        Run.timing.syslogdropped++;
+                                } else {
+                                        SyslogRecord_T r = &_syslogger.queue[_syslogger.head];
+                                        r->priority = priority & LOG_PRIMASK;
+                                        r->time = time;
+                                        r->length = length;
+                                        memcpy(r->message, message, length);
+                                        _syslogger.head = (_syslogger.head + 1) % SYSLOG_QUEUE;
+                                        if (_syslogger.count++ == 0)
+                                                Sem_signal(_syslogger.cond);
+                                }
+                        }
+                }
+                END_LOCK;
+        }
+        return queued;
+}
+
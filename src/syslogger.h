@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+
+#ifndef MONIT_SYSLOGGER_H
+#define MONIT_SYSLOGGER_H
+
+
+/**
+ * Syslog client which sends the log messages to the syslog server set by
+ * "set log syslog address", instead of the local syslog(3).
+ *
+ * The messages are formatted according to RFC 5424 and sent over UDP, one
+ * message per datagram, or over TCP with the RFC 6587 octet counting
+ * framing. Syslogger_send() only copies the message to a bounded in-memory
+ * queue, a sender thread writes the queued messages in batches. If the
+ * server is unreachable, the messages stay queued and the connection is
+ * retried with an exponential backoff; when the queue is full, new messages
+ * are dropped. The sent and dropped messages and the send errors are counted
+ * in Run.timing and shown by "monit stats".
+ *
+ *  @file
+ */
+
+
+/**
+ * Start the sender thread if a syslog server is set. Must be called after
+ * the daemon has forked
+ */
+void Syslogger_start();
+
+
+/**
+ * Stop the sender thread after it has sent the queued messages. If the
+ * server is not reachable, the remaining messages are dropped
+ */
+void Syslogger_stop();
+
+
+/**
+ * Queue the message for the syslog server. If the queue is full, the
+ * message is dropped
+ * @param priority The syslog priority of the message
+ * @param time The message timestamp
+ * @param message The message text, a trailing newline is removed
+ * @param length The message length
+ * @return true if the sender thread is running and the message was
+ * handled, false if the caller should use the local syslog
+ */
+boolean_t Syslogger_send(int priority, time_t time, const char *message, int length);
+
+
+#endif
+
@@ -167,7 +167,7 @@ static boolean_t _printRow(T t) {
                                 // The value exceeds the column width and should be wrapped
                                 int column = 0;
                                 for (; t->columns[i].value[t->columns[i]._cursor] && (column == 0 || t->columns[i]._cursor % t->columns[i].width > 0); t->columns[i]._cursor++, column++)
-                                        StringBuffer_append(t->b, "%c", t->columns[i].value[t->columns[i]._cursor]);
+                                        StringBuffer_appendChar(t->b, t->columns[i].value[t->columns[i]._cursor]);
                                 if (t->columns[i]._cursor < t->columns[i]._valueLength)
                                         repeat = true;
                         } else {
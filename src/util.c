@@ -225,7 +225,7 @@ static const unsigned char b2x[][256] = {
  * Returns the value of the parameter if defined or the String "(not
  * defined)"
  */
-static char *is_str_defined(char *s) {
+static const char *is_str_defined(const char *s) {
         return((s && *s) ? s : "(not defined)");
 }
 
@@ -774,10 +774,13 @@ void Util_hmacMD5(const unsigned char *data, int datalen, const unsigned char *k
 
 Service_T Util_getService(const char *name) {
         ASSERT(name);
-        for (Service_T s = servicelist; s; s = s->next)
-                if (IS(s->name, name))
-                        return s;
-        return NULL;
+        return servicetable ? Table_get(servicetable, name) : NULL;
+}
+
+
+ServiceGroup_T Util_getServiceGroup(const char *name) {
+        ASSERT(name);
+        return servicegrouptable ? Table_get(servicegrouptable, name) : NULL;
 }
 
 
@@ -806,6 +809,9 @@ void Util_printRunList() {
         printf(" %-18s = %s\n", "State file", is_str_defined(Run.files.state));
         printf(" %-18s = %s\n", "Debug", Run.debug ? "True" : "False");
         printf(" %-18s = %s\n", "Log", (Run.flags & Run_Log) ? "True" : "False");
+        printf(" %-18s = %s\n", "Log format", (Run.flags & Run_LogJson) ? "json" : "text");
+        if (Run.syslog.host)
+                printf(" %-18s = [%s]:%d/%s\n", "Syslog server", Run.syslog.host, Run.syslog.port, Run.syslog.type == Socket_Tcp ? "TCP" : "UDP");
         printf(" %-18s = %s\n", "Use syslog", (Run.flags & Run_UseSyslog) ? "True" : "False");
         printf(" %-18s = %s\n", "Is Daemon", (Run.flags & Run_Daemon) ? "True" : "False");
         printf(" %-18s = %s\n", "Use process engine", (Run.flags & Run_ProcessEngineEnabled) ? "True" : "False");
@@ -821,7 +827,11 @@ void Util_printRunList() {
         printf(" %-18s =   restartTimeout:    %s\n", " ", Str_milliToTime(Run.limits.restartTimeout, (char[23]){}));
         printf(" %-18s = }\n", " ");
         printf(" %-18s = %s\n", "On reboot", onrebootnames[Run.onreboot]);
-        printf(" %-18s = %d seconds with start delay %d seconds\n", "Poll time", Run.polltime, Run.startdelay);
+        printf(" %-18s = %d seconds with start delay %d seconds%s\n", "Poll time", Run.polltime, Run.startdelay, Run.flags & Run_SpreadChecks ? ", checks spread over the interval" : "");
+        if (Run.watchdog.timeout)
+                printf(" %-18s = timeout %d seconds%s\n", "Watchdog", Run.watchdog.timeout, Run.watchdog.isolate ? ", isolate stalled services" : "");
+        else
+                printf(" %-18s = %s\n", "Watchdog", "disabled");
 
         if (Run.eventlist_dir) {
                 char slots[STRLEN];
@@ -1296,6 +1306,18 @@ void Util_printService(Service_T s) {
                                 printf(" %-20s = ", "CPU wait limit");
                                 break;
 
+                        case Resource_CpuSteal:
+                                printf(" %-20s = ", "CPU steal limit");
+                                break;
+
+                        case Resource_CpuGuest:
+                                printf(" %-20s = ", "CPU guest limit");
+                                break;
+
+                        case Resource_CpuCore:
+                                printf(" %-20s = ", "CPU core limit");
+                                break;
+
                         case Resource_MemoryPercent:
                                 printf(" %-20s = ", "Memory usage limit");
                                 break;
@@ -1366,6 +1388,9 @@ void Util_printService(Service_T s) {
                         case Resource_CpuUser:
                         case Resource_CpuSystem:
                         case Resource_CpuWait:
+                        case Resource_CpuSteal:
+                        case Resource_CpuGuest:
+                        case Resource_CpuCore:
                         case Resource_MemoryPercent:
                         case Resource_SwapPercent:
                                 printf("%s", StringBuffer_toString(Util_printRule(buf, o->action, "if %s %.1f%%", operatornames[o->operator], o->limit)));
@@ -1410,6 +1435,12 @@ void Util_printService(Service_T s) {
                 printf(" %-20s = Check service every %s\n", "Every", s->every.spec.cron);
         else if (s->every.type == Every_NotInCron)
                 printf(" %-20s = Don't check service every %s\n", "Every", s->every.spec.cron);
+        else if (s->every.type == Every_Interval) {
+                printf(" %-20s = Check service every %s", "Every", Str_milliToTime(s->every.spec.interval.base, (char[23]){}));
+                if (s->every.spec.interval.max)
+                        printf(" adaptive to %s", Str_milliToTime(s->every.spec.interval.max, (char[23]){}));
+                printf("\n");
+        }
 
         for (ActionRate_T o = s->actionratelist; o; o = o->next) {
                 StringBuffer_clear(buf);
@@ -2052,3 +2083,21 @@ const char *Util_timestr(int time) {
         return NULL;
 }
 
+
+long long Util_updateTiming(Timing_T *timing, long long start) {
+        ASSERT(timing);
+        static long long limits[TIMING_BUCKETS - 1] = {1000LL, 10000LL, 100000LL, 500000LL, 1000000LL, 5000000LL, 30000000LL}; // Upper bucket limits [us], see timingnames
+        long long duration = Time_monotonicMicro() - start;
+        if (duration < 0)
+                duration = 0;
+        int bucket = 0;
+        while (bucket < TIMING_BUCKETS - 1 && duration > limits[bucket])
+                bucket++;
+        timing->histogram[bucket]++;
+        timing->count++;
+        timing->total += duration;
+        timing->last = duration;
+        if ((unsigned long long)duration > timing->max)
+                timing->max = duration;
+        return duration;
+}
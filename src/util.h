@@ -131,6 +131,13 @@ void Util_hmacMD5(const unsigned char *data, int datalen, const unsigned char *k
 Service_T Util_getService(const char *name);
 
 
+/**
+ * @param name A service group name as stated in the config file
+ * @return the named service group or NULL if not found
+ */
+ServiceGroup_T Util_getServiceGroup(const char *name);
+
+
 /**
  * @param name A service name as stated in the config file
  * @return true if the service name exist in the
@@ -406,5 +413,15 @@ char *Util_commandDescription(command_t command, char s[STRLEN]);
 const char *Util_timestr(int time);
 
 
+/**
+ * Add a duration measurement to the timing statistics. The duration is
+ * measured from start until now.
+ * @param timing The timing statistics
+ * @param start The start time as returned by Time_monotonicMicro()
+ * @return The measured duration [us]
+ */
+long long Util_updateTiming(Timing_T *timing, long long start);
+
+
 #endif
 
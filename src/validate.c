@@ -65,6 +65,10 @@
 #include <string.h>
 #endif
 
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -101,10 +105,12 @@
 #include "device.h"
 #include "ProcessTree.h"
 #include "protocol.h"
+#include "watchdog.h"
 
 // libmonit
 #include "system/Time.h"
 #include "io/File.h"
+#include "io/FileCache.h"
 #include "io/InputStream.h"
 #include "exceptions/AssertException.h"
 
@@ -115,6 +121,30 @@
  */
 
 
+/* ------------------------------------------------------------- Definitions */
+
+
+#define ADAPTIVE_MARGIN 0.1 // Relative distance to a resource limit which resets the adaptive check interval
+
+
+/**
+ * Compact copy of the scheduling state of the services checked on their own schedule. The main loop calls
+ * validate_interval() on every wakeup, which scans this contiguous array instead of walking the service list
+ */
+typedef struct Schedule_T {
+        long long next;                      /**< Copy of service every.next [ms] */
+        Service_T service;                              /**< The scheduled service */
+        Service_Type refresh;     /**< Service_System or Service_Process if the check needs fresh data */
+} *Schedule_T;
+
+
+static struct {
+        int count;
+        int capacity;
+        Schedule_T entries;
+} _schedule = {};
+
+
 /* ----------------------------------------------------------------- Private */
 
 
@@ -128,11 +158,9 @@ static void _programOutput(InputStream_T I, StringBuffer_T S) {
         char buf[STRLEN];
         InputStream_setTimeout(I, 0);
         do {
-                n = InputStream_readBytes(I, buf, sizeof(buf) - 1);
-                if (n > 0 && StringBuffer_length(S) < Run.limits.programOutput) {
-                        buf[n] = 0;
-                        StringBuffer_append(S, "%s", buf);
-                }
+                n = InputStream_readBytes(I, buf, sizeof(buf));
+                if (n > 0 && StringBuffer_length(S) < Run.limits.programOutput)
+                        StringBuffer_appendBytes(S, buf, n);
         } while (n > 0);
 }
 
@@ -231,6 +259,21 @@ static State_Type _checkProcessPpid(Service_T s) {
 }
 
 
+/**
+ * Evaluate the resource value against the limit. For adaptive check interval, note if the value approached the
+ * limit within ADAPTIVE_MARGIN, so the service is checked with the base interval again
+ * @return true if the value matches the limit, otherwise false
+ */
+static boolean_t _checkResourceLimit(Service_T s, Resource_T r, double value) {
+        if (s->every.type == Every_Interval && s->every.spec.interval.max) {
+                if (((r->operator == Operator_Greater || r->operator == Operator_GreaterOrEqual) && value >= r->limit * (1. - ADAPTIVE_MARGIN)) ||
+                    ((r->operator == Operator_Less || r->operator == Operator_LessOrEqual) && value <= r->limit * (1. + ADAPTIVE_MARGIN)))
+                        s->every.spec.interval.nearLimit = true;
+        }
+        return Util_evalDoubleQExpression(r->operator, value, r->limit);
+}
+
+
 /**
  * Check process resources
  */
@@ -244,7 +287,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->cpu_percent < 0.) {
                                 DEBUG("'%s' cpu usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->cpu_percent, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->cpu_percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "cpu usage of %.1f%% matches resource limit [cpu usage %s %.1f%%]", s->inf.process->cpu_percent, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -256,7 +299,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->total_cpu_percent < 0.) {
                                 DEBUG("'%s' total cpu usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->total_cpu_percent, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->total_cpu_percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "total cpu usage of %.1f%% matches resource limit [cpu usage %s %.1f%%]", s->inf.process->total_cpu_percent, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -268,7 +311,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->mem_percent < 0.) {
                                 DEBUG("'%s' memory usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->mem_percent, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->mem_percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "mem usage of %.1f%% matches resource limit [mem usage %s %.1f%%]", s->inf.process->mem_percent, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -280,7 +323,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->mem == 0) {
                                 DEBUG("'%s' process memory usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->mem, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->mem)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "mem amount of %s matches resource limit [mem amount %s %s]", Str_bytesToSize(s->inf.process->mem, buf1), operatorshortnames[r->operator], Str_bytesToSize(r->limit, buf2));
                         } else {
@@ -292,7 +335,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->threads < 0) {
                                 DEBUG("'%s' process threads count check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->threads, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->threads)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "threads count %i matches resource limit [threads %s %.0f]", s->inf.process->threads, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -304,7 +347,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->children < 0) {
                                 DEBUG("'%s' process children count check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->children, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->children)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "children count %i matches resource limit [children %s %.0f]", s->inf.process->children, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -316,7 +359,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->total_mem == 0) {
                                 DEBUG("'%s' process total memory usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->total_mem, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->total_mem)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "total mem amount of %s matches resource limit [total mem amount %s %s]", Str_bytesToSize(s->inf.process->total_mem, buf1), operatorshortnames[r->operator], Str_bytesToSize(r->limit, buf2));
                         } else {
@@ -328,7 +371,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                         if (s->inf.process->total_mem_percent < 0.) {
                                 DEBUG("'%s' total memory usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, s->inf.process->total_mem_percent, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, s->inf.process->total_mem_percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "total mem amount of %.1f%% matches resource limit [total mem amount %s %.1f%%]", (float)s->inf.process->total_mem_percent, operatorshortnames[r->operator], (float)r->limit);
                         } else {
@@ -339,7 +382,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                 case Resource_ReadBytes:
                         if (Statistics_initialized(&(s->inf.process->read.bytes))) {
                                 double value = Statistics_deltaNormalize(&(s->inf.process->read.bytes));
-                                if (Util_evalDoubleQExpression(r->operator, value, r->limit)) {
+                                if (_checkResourceLimit(s, r, value)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "read rate %s/s matches resource limit [read %s %s/s]", Str_bytesToSize(value, (char[10]){}), operatorshortnames[r->operator], Str_bytesToSize(r->limit, (char[10]){}));
                                 } else {
@@ -354,7 +397,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                 case Resource_ReadOperations:
                         if (Statistics_initialized(&(s->inf.process->read.operations))) {
                                 double value = Statistics_deltaNormalize(&(s->inf.process->read.operations));
-                                if (Util_evalDoubleQExpression(r->operator, value, r->limit)) {
+                                if (_checkResourceLimit(s, r, value)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "read rate %.1f operations/s matches resource limit [read %s %.0f operations/s]", value, operatorshortnames[r->operator], r->limit);
                                 } else {
@@ -369,7 +412,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                 case Resource_WriteBytes:
                         if (Statistics_initialized(&(s->inf.process->write.bytes))) {
                                 double value = Statistics_deltaNormalize(&(s->inf.process->write.bytes));
-                                if (Util_evalDoubleQExpression(r->operator, value, r->limit)) {
+                                if (_checkResourceLimit(s, r, value)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "write rate %s/s matches resource limit [write %s %s/s]", Str_bytesToSize(value, (char[10]){}), operatorshortnames[r->operator], Str_bytesToSize(r->limit, (char[10]){}));
                                 } else {
@@ -384,7 +427,7 @@ static State_Type _checkProcessResources(Service_T s, Resource_T r) {
                 case Resource_WriteOperations:
                         if (Statistics_initialized(&(s->inf.process->write.operations))) {
                                 double value = Statistics_deltaNormalize(&(s->inf.process->write.operations));
-                                if (Util_evalDoubleQExpression(r->operator, value, r->limit)) {
+                                if (_checkResourceLimit(s, r, value)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "write rate %.1f operations/s matches resource limit [write %s %.0f operations/s]", value, operatorshortnames[r->operator], r->limit);
                                 } else {
@@ -422,7 +465,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                                 if (cpu < 0.) {
                                         DEBUG("'%s' cpu usage check skipped (initializing)\n", s->name);
                                         return State_Init;
-                                } else if (Util_evalDoubleQExpression(r->operator, cpu, r->limit)) {
+                                } else if (_checkResourceLimit(s, r, cpu)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "cpu usage of %.1f%% matches resource limit [cpu usage %s %.1f%%]", cpu, operatorshortnames[r->operator], r->limit);
                                 } else {
@@ -435,7 +478,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         if (systeminfo.cpu.usage.user < 0.) {
                                 DEBUG("'%s' cpu user usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, systeminfo.cpu.usage.user, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, systeminfo.cpu.usage.user)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "cpu user usage of %.1f%% matches resource limit [cpu user usage %s %.1f%%]", systeminfo.cpu.usage.user, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -447,7 +490,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         if (systeminfo.cpu.usage.system < 0.) {
                                 DEBUG("'%s' cpu system usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, systeminfo.cpu.usage.system, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, systeminfo.cpu.usage.system)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "cpu system usage of %.1f%% matches resource limit [cpu system usage %s %.1f%%]", systeminfo.cpu.usage.system, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -459,7 +502,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         if (systeminfo.cpu.usage.wait < 0.) {
                                 DEBUG("'%s' cpu wait usage check skipped (initializing)\n", s->name);
                                 return State_Init;
-                        } else if (Util_evalDoubleQExpression(r->operator, systeminfo.cpu.usage.wait, r->limit)) {
+                        } else if (_checkResourceLimit(s, r, systeminfo.cpu.usage.wait)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "cpu wait usage of %.1f%% matches resource limit [cpu wait usage %s %.1f%%]", systeminfo.cpu.usage.wait, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -467,8 +510,54 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         }
                         break;
 
+                case Resource_CpuSteal:
+                        if (systeminfo.cpu.usage.steal < 0.) {
+                                DEBUG("'%s' cpu steal usage check skipped (initializing)\n", s->name);
+                                return State_Init;
+                        } else if (_checkResourceLimit(s, r, systeminfo.cpu.usage.steal)) {
+                                rv = State_Failed;
+                                snprintf(report, STRLEN, "cpu steal usage of %.1f%% matches resource limit [cpu steal usage %s %.1f%%]", systeminfo.cpu.usage.steal, operatorshortnames[r->operator], r->limit);
+                        } else {
+                                snprintf(report, STRLEN, "cpu steal usage check succeeded [current cpu steal usage = %.1f%%]", systeminfo.cpu.usage.steal);
+                        }
+                        break;
+
+                case Resource_CpuGuest:
+                        if (systeminfo.cpu.usage.guest < 0.) {
+                                DEBUG("'%s' cpu guest usage check skipped (initializing)\n", s->name);
+                                return State_Init;
+                        } else if (_checkResourceLimit(s, r, systeminfo.cpu.usage.guest)) {
+                                rv = State_Failed;
+                                snprintf(report, STRLEN, "cpu guest usage of %.1f%% matches resource limit [cpu guest usage %s %.1f%%]", systeminfo.cpu.usage.guest, operatorshortnames[r->operator], r->limit);
+                        } else {
+                                snprintf(report, STRLEN, "cpu guest usage check succeeded [current cpu guest usage = %.1f%%]", systeminfo.cpu.usage.guest);
+                        }
+                        break;
+
+                case Resource_CpuCore:
+                        if (systeminfo.cpu.core.max < 0. || ! systeminfo.cpu.core.count) {
+                                DEBUG("'%s' cpu core usage check skipped (initializing)\n", s->name);
+                                return State_Init;
+                        } else {
+                                // Report the first core which matches the limit, otherwise the busiest one
+                                int core = -1;
+                                for (int i = 0; i < systeminfo.cpu.core.count; i++) {
+                                        if (_checkResourceLimit(s, r, systeminfo.cpu.core.sample[i].usage)) {
+                                                core = i;
+                                                break;
+                                        }
+                                }
+                                if (core >= 0) {
+                                        rv = State_Failed;
+                                        snprintf(report, STRLEN, "cpu core %d usage of %.1f%% matches resource limit [any core usage %s %.1f%%]", systeminfo.cpu.core.sample[core].id, systeminfo.cpu.core.sample[core].usage, operatorshortnames[r->operator], r->limit);
+                                } else {
+                                        snprintf(report, STRLEN, "cpu core usage check succeeded [current max core usage = %.1f%%]", systeminfo.cpu.core.max);
+                                }
+                        }
+                        break;
+
                 case Resource_MemoryPercent:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.memory.usage.percent, r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.memory.usage.percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "mem usage of %.1f%% matches resource limit [mem usage %s %.1f%%]", systeminfo.memory.usage.percent, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -477,7 +566,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         break;
 
                 case Resource_MemoryKbyte:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.memory.usage.bytes, r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.memory.usage.bytes)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "mem amount of %s matches resource limit [mem amount %s %s]", Str_bytesToSize(systeminfo.memory.usage.bytes, buf1), operatorshortnames[r->operator], Str_bytesToSize(r->limit, buf2));
                         } else {
@@ -486,7 +575,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         break;
 
                 case Resource_SwapPercent:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.swap.usage.percent, r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.swap.usage.percent)) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "swap usage of %.1f%% matches resource limit [swap usage %s %.1f%%]", systeminfo.swap.usage.percent, operatorshortnames[r->operator], r->limit);
                         } else {
@@ -496,7 +585,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
 
                 case Resource_SwapKbyte:
                         if (s->type == Service_System) {
-                                if (Util_evalDoubleQExpression(r->operator, systeminfo.swap.usage.bytes, r->limit)) {
+                                if (_checkResourceLimit(s, r, systeminfo.swap.usage.bytes)) {
                                         rv = State_Failed;
                                         snprintf(report, STRLEN, "swap amount of %s matches resource limit [swap amount %s %s]", Str_bytesToSize(systeminfo.swap.usage.bytes, buf1), operatorshortnames[r->operator], Str_bytesToSize(r->limit, buf2));
                                 } else {
@@ -506,7 +595,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         break;
 
                 case Resource_LoadAverage1m:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.loadavg[0], r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.loadavg[0])) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "loadavg(1min) of %.1f matches resource limit [loadavg(1min) %s %.1f]", systeminfo.loadavg[0], operatorshortnames[r->operator], r->limit);
                         } else {
@@ -515,7 +604,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         break;
 
                 case Resource_LoadAverage5m:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.loadavg[1], r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.loadavg[1])) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "loadavg(5min) of %.1f matches resource limit [loadavg(5min) %s %.1f]", systeminfo.loadavg[1], operatorshortnames[r->operator], r->limit);
                         } else {
@@ -524,7 +613,7 @@ static State_Type _checkSystemResources(Service_T s, Resource_T r) {
                         break;
 
                 case Resource_LoadAverage15m:
-                        if (Util_evalDoubleQExpression(r->operator, systeminfo.loadavg[2], r->limit)) {
+                        if (_checkResourceLimit(s, r, systeminfo.loadavg[2])) {
                                 rv = State_Failed;
                                 snprintf(report, STRLEN, "loadavg(15min) of %.1f matches resource limit [loadavg(15min) %s %.1f]", systeminfo.loadavg[2], operatorshortnames[r->operator], r->limit);
                         } else {
@@ -918,7 +1007,7 @@ next:
                                         DEBUG("'%s' Pattern %s'%s' match on content line [%s]\n", s->name, ml->not ? "not " : "", ml->match_string, line);
                                         /* Save the line for Event_post */
                                         if (! ml->log)
-                                                ml->log = StringBuffer_create(Run.limits.fileContentBuffer);
+                                                ml->log = StringBuffer_borrow(Run.limits.fileContentBuffer);
                                         if (StringBuffer_length(ml->log) < Run.limits.fileContentBuffer) {
                                                 StringBuffer_append(ml->log, "%s\n", line);
                                                 if (StringBuffer_length(ml->log) >= Run.limits.fileContentBuffer)
@@ -941,7 +1030,7 @@ final1:
                         if (ml->log) {
                                 rv = State_Changed;
                                 Event_post(s, Event_Content, State_Changed, ml->action, "content match:\n%s", StringBuffer_toString(ml->log));
-                                StringBuffer_free(&ml->log);
+                                StringBuffer_release(&ml->log);
                         } else {
                                 Event_post(s, Event_Content, State_ChangedNot, ml->action, "content doesn't match");
                         }
@@ -1181,23 +1270,105 @@ static void _checkTimeout(Service_T s) {
 }
 
 
+/**
+ * Returns the monotonic time of the next check of a cron service: the start of the next minute which matches the
+ * compiled cron specification. The deadline is at most one hour ahead, so changes of the wall clock are followed
+ */
+static long long _cronNext(Service_T s, time_t now, long long monotonic) {
+        long long delay = 3600000LL;
+        time_t next = Time_cronNext(&s->every.crontab, now);
+        if (next) {
+                long long wait = next * 1000LL - Time_milli();
+                if (wait < delay)
+                        delay = wait > 0 ? wait : 0;
+        }
+        return monotonic + delay;
+}
+
+
 static boolean_t _incron(Service_T s, time_t now) {
-        if ((now - s->every.last_run) > 59) { // Minute is the lowest resolution, so only run once per minute
-                if (Time_incron(s->every.spec.cron, now)) {
-                        s->every.last_run = now;
-                        return true;
-                }
+        long long monotonic = Time_monotonic();
+        if (monotonic < s->every.next) // Minute is the lowest resolution, so only run once per matching minute
+                return false;
+        s->every.next = _cronNext(s, now, monotonic);
+        if (Time_cronMatch(&s->every.crontab, now)) {
+                s->every.last_run = now;
+                return true;
         }
         return false;
 }
 
 
+/**
+ * Returns true if the service check is spread over the poll interval
+ */
+static boolean_t _isSpread(Service_T s) {
+        return (Run.flags & Run_SpreadChecks) && (s->every.type == Every_Cycle || s->every.type == Every_SkipCycles);
+}
+
+
+/**
+ * Returns true if the service is checked on its own schedule, independent of the poll cycle start
+ */
+static boolean_t _isScheduled(Service_T s) {
+        return s->every.type == Every_Interval || s->every.type == Every_Cron || _isSpread(s);
+}
+
+
+/**
+ * Rebuild the schedule array from the monitored services checked on their own schedule
+ */
+static void _scheduleBuild() {
+        _schedule.count = 0;
+        for (Service_T s = servicelist; s; s = s->next) {
+                if (s->monitor && _isScheduled(s)) {
+                        if (_schedule.count == _schedule.capacity) {
+                                _schedule.capacity = _schedule.capacity ? _schedule.capacity * 2 : 16;
+                                RESIZE(_schedule.entries, _schedule.capacity * sizeof(*_schedule.entries));
+                        }
+                        Schedule_T e = &_schedule.entries[_schedule.count++];
+                        e->next = s->every.next;
+                        e->service = s;
+                        e->refresh = (s->every.type == Every_Interval || s->every.type == Every_Cron) && (s->type == Service_System || s->type == Service_Process) ? s->type : Service_Last + 1;
+                }
+        }
+}
+
+
+/**
+ * Returns the monotonic time of the next check of a spread service: the nearest time after now which matches the
+ * service phase in the poll interval. The phase is derived from the host and service name, so it is stable across
+ * restarts while different services and hosts are checked at different times
+ */
+static long long _spreadNext(Service_T s, long long now) {
+        long long interval = Run.polltime * 1000LL;
+        long long phase = (long long)((Str_hash(Run.system->name) * 31U + Str_hash(s->name)) % (unsigned long long)interval);
+        return now - ((now - phase) % interval + interval) % interval + interval;
+}
+
+
 /**
  * Returns true if validation should be skiped for this service in this cycle, otherwise false. Handle every statement
  */
 static boolean_t _checkSkip(Service_T s) {
         ASSERT(s);
         time_t now = Time_now();
+        if (s->stall.until) {
+                long long monotonic = Time_monotonic();
+                if (monotonic < s->stall.until) {
+                        DEBUG("'%s' test skipped as the service is isolated after a stalled check for next %lld ms\n", s->name, s->stall.until - monotonic);
+                        return true;
+                }
+                s->stall.until = 0;
+        }
+        if (_isSpread(s)) {
+                long long monotonic = Time_monotonic();
+                if (monotonic < s->every.next) {
+                        DEBUG("'%s' test skipped as its phase in the poll interval is due in %lld ms\n", s->name, s->every.next - monotonic);
+                        return true;
+                }
+                s->every.next = _spreadNext(s, monotonic);
+        }
         if (s->every.type == Every_SkipCycles) {
                 s->every.spec.cycle.counter++;
                 if (s->every.spec.cycle.counter < s->every.spec.cycle.number) {
@@ -1210,10 +1381,17 @@ static boolean_t _checkSkip(Service_T s) {
                 s->monitor |= Monitor_Waiting;
                 DEBUG("'%s' test skipped as current time (%lld) does not match every's cron spec \"%s\"\n", s->name, (long long)now, s->every.spec.cron);
                 return true;
-        } else if (s->every.type == Every_NotInCron && Time_incron(s->every.spec.cron, now)) {
+        } else if (s->every.type == Every_NotInCron && Time_cronMatch(&s->every.crontab, now)) {
                 s->monitor |= Monitor_Waiting;
                 DEBUG("'%s' test skipped as current time (%lld) matches every's cron spec \"not %s\"\n", s->name, (long long)now, s->every.spec.cron);
                 return true;
+        } else if (s->every.type == Every_Interval) {
+                long long monotonic = Time_monotonic();
+                if (monotonic < s->every.next) {
+                        DEBUG("'%s' test skipped as next check is due in %lld ms\n", s->name, s->every.next - monotonic);
+                        return true;
+                }
+                s->every.next = monotonic + s->every.spec.interval.current;
         }
         s->monitor &= ~Monitor_Waiting;
         // Skip if parent is not initialized
@@ -1246,6 +1424,70 @@ static boolean_t _doScheduledAction(Service_T s) {
 }
 
 
+static void _updateSystemInfo() {
+        long long start = Time_monotonicMicro();
+        update_system_info();
+        Util_updateTiming(&Run.timing.system, start);
+}
+
+
+static void _updateProcessTree() {
+        long long start = Time_monotonicMicro();
+        ProcessTree_init(ProcessEngine_None);
+        Util_updateTiming(&Run.timing.processes, start);
+}
+
+
+/**
+ * Adapt the check interval of the service: the interval grows by a quarter with each successful check up to the
+ * maximum, if the check failed, some event is in failed state or a resource value approached its limit, the interval
+ * drops back to the configured base value
+ */
+static void _adaptInterval(Service_T s, State_Type state) {
+        int current = s->every.spec.interval.current;
+        if (state == State_Failed || s->error || s->every.spec.interval.nearLimit) {
+                s->every.spec.interval.current = s->every.spec.interval.base;
+                if (current != s->every.spec.interval.base)
+                        DEBUG("'%s' adaptive check interval reset to %s\n", s->name, Str_milliToTime(s->every.spec.interval.base, (char[23]){}));
+        } else if (state == State_Succeeded && current < s->every.spec.interval.max) {
+                s->every.spec.interval.current = current + (current / 4 > 0 ? current / 4 : 1);
+                if (s->every.spec.interval.current > s->every.spec.interval.max)
+                        s->every.spec.interval.current = s->every.spec.interval.max;
+                DEBUG("'%s' adaptive check interval increased to %s\n", s->name, Str_milliToTime(s->every.spec.interval.current, (char[23]){}));
+        }
+        s->every.spec.interval.nearLimit = false;
+        // The next check was scheduled with the old interval before the check => move it
+        s->every.next += s->every.spec.interval.current - current;
+}
+
+
+/**
+ * Check the service if it is due in this cycle
+ * @return State_Failed if the check failed, State_Init if it was skipped, otherwise State_Succeeded
+ */
+static State_Type _checkService(Service_T s) {
+        State_Type state = State_Init;
+        // FIXME: The Service_Program must collect the exit value from last run, even if the program start should be skipped in this cycle => let check program always run the test (to be refactored with new scheduler)
+        // check_program() calls _checkSkip() itself. It must not be called here as well for any schedule type: it advances the interval and spread schedule, so the second call would always skip and the program would never start
+        if (! _doScheduledAction(s) && s->monitor && (s->type == Service_Program || ! _checkSkip(s))) {
+                _checkTimeout(s); // Can disable monitoring => need to check s->monitor again
+                if (s->monitor) {
+                        long long start = Time_monotonicMicro();
+                        Watchdog_enter(s);
+                        state = s->check(s);
+                        Watchdog_leave(s);
+                        Util_updateTiming(&s->timing, start);
+                        if (state != State_Init && s->monitor != Monitor_Not) // The monitoring can be disabled by some matching rule in s->check so we have to check again before setting to Monitor_Yes
+                                s->monitor = Monitor_Yes;
+                        if (s->every.type == Every_Interval && s->every.spec.interval.max)
+                                _adaptInterval(s, state);
+                }
+                gettimeofday(&s->collected, NULL);
+        }
+        return state;
+}
+
+
 /* ---------------------------------------------------------------- Public */
 
 
@@ -1255,11 +1497,13 @@ static boolean_t _doScheduledAction(Service_T s) {
  *  they will pass all defined tests.
  */
 int validate() {
+        long long start = Time_monotonicMicro();
         Run.handler_flag = Handler_Succeeded;
         Event_queue_process();
+        Util_updateTiming(&Run.timing.events, start);
 
-        update_system_info();
-        ProcessTree_init(ProcessEngine_None);
+        _updateSystemInfo();
+        _updateProcessTree();
         gettimeofday(&systeminfo.collected, NULL);
 
         /* In the case that at least one action is pending, perform quick loop to handle the actions ASAP */
@@ -1274,18 +1518,20 @@ int validate() {
         for (Service_T s = servicelist; s; s = s->next) {
                 if (Run.flags & Run_Stopped)
                         break;
-                // FIXME: The Service_Program must collect the exit value from last run, even if the program start should be skipped in this cycle => let check program always run the test (to be refactored with new scheduler)
-                if (! _doScheduledAction(s) && s->monitor && (s->type == Service_Program || ! _checkSkip(s))) {
-                        _checkTimeout(s); // Can disable monitoring => need to check s->monitor again
-                        if (s->monitor) {
-                                State_Type state = s->check(s);
-                                if (state != State_Init && s->monitor != Monitor_Not) // The monitoring can be disabled by some matching rule in s->check so we have to check again before setting to Monitor_Yes
-                                        s->monitor = Monitor_Yes;
-                                if (state == State_Failed)
-                                        errors++;
-                        }
-                        gettimeofday(&s->collected, NULL);
-                }
+                if (_checkService(s) == State_Failed)
+                        errors++;
+        }
+        if (Run.debug) {
+                int files;
+                unsigned long long reads, opens;
+                FileCache_statistics(&files, &reads, &opens);
+                DEBUG("File cache: %d descriptors open, %llu reads, %llu open/close calls saved\n", files, reads, reads > opens ? reads - opens : 0ULL);
+        }
+        _scheduleBuild();
+        long long duration = Util_updateTiming(&Run.timing.cycle, start);
+        if (Run.polltime > 0 && duration > Run.polltime * 1000000LL) {
+                Run.timing.overruns++;
+                LogWarning("Monit cycle took %s which exceeds the poll time %ds\n", Str_milliToTime(duration / 1000., (char[23]){}), Run.polltime);
         }
         return errors;
 }
@@ -1898,3 +2144,63 @@ State_Type check_net(Service_T s) {
 }
 
 
+/**
+ * Check the services with an own schedule which are due: services with a
+ * millisecond interval, cron services at their next matching minute and,
+ * if checks are spread over the poll interval, the cycle based services.
+ * This function is called between the poll cycles. The system and process
+ * data are refreshed only if a due interval or cron service needs them,
+ * the spread services use the data collected at the start of the cycle.
+ * @return The monotonic time [ms] of the nearest scheduled check or 0 if
+ * no service has an own schedule
+ */
+long long validate_interval() {
+        long long now = Time_monotonic();
+        boolean_t due = false, system = false, process = false;
+        for (int i = 0; i < _schedule.count; i++) {
+                Schedule_T e = &_schedule.entries[i];
+                if (now >= e->next) {
+                        due = true;
+                        if (e->refresh == Service_System)
+                                system = true;
+                        else if (e->refresh == Service_Process)
+                                process = true;
+                }
+        }
+        if (due) {
+                if (system)
+                        _updateSystemInfo();
+                if (process)
+                        _updateProcessTree();
+                for (int i = 0; i < _schedule.count; i++) {
+                        if (Run.flags & Run_Stopped)
+                                break;
+                        Schedule_T e = &_schedule.entries[i];
+                        if (Time_monotonic() >= e->next) {
+                                Service_T s = e->service;
+                                if (! s->monitor) {
+                                        // Unmonitored since the last cycle, drop it until validate() rebuilds the array
+                                        e->next = LLONG_MAX;
+                                        continue;
+                                }
+                                _checkService(s);
+                                if (s->every.next <= now) { // The check was postponed by a pending action => reschedule
+                                        if (s->every.type == Every_Interval)
+                                                s->every.next = now + s->every.spec.interval.current;
+                                        else if (s->every.type == Every_Cron)
+                                                s->every.next = _cronNext(s, Time_now(), now);
+                                        else
+                                                s->every.next = _spreadNext(s, now);
+                                }
+                                e->next = s->every.next;
+                        }
+                }
+        }
+        long long next = LLONG_MAX;
+        for (int i = 0; i < _schedule.count; i++)
+                if (_schedule.entries[i].next < next)
+                        next = _schedule.entries[i].next;
+        if (next == LLONG_MAX)
+                return 0LL;
+        return next < 1 ? 1 : next;
+}
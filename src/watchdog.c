@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+
+#include "monit.h"
+#include "event.h"
+#include "watchdog.h"
+
+// libmonit
+#include "system/Time.h"
+#include "exceptions/AssertException.h"
+
+
+/**
+ * Implementation of the service check watchdog, see watchdog.h
+ *
+ * @file
+ */
+
+
+/* ------------------------------------------------------------- Definitions */
+
+
+/* Maximum isolation backoff exponent: the service is isolated for at most 2^6 watchdog timeouts */
+#define ISOLATE_MAX_SHIFT 6
+
+
+static Thread_T thread;
+static Sem_T cond;
+static Mutex_T mutex;
+static boolean_t running = false;
+static struct {
+        Service_T service;                      /**< The currently checked service */
+        long long started;         /**< Monotonic start time [ms] of the check */
+        long long stalled;   /**< Check duration [ms] when the stall was detected, 0 = not stalled */
+} current = {};
+
+
+/* ----------------------------------------------------------------- Private */
+
+
+/**
+ * The watchdog thread sends the stall notification itself while the check is still hung. It uses
+ * Event_notify(), which doesn't touch the event list owned by the validation thread and serializes
+ * the alert delivery. The watchdog mutex is released during the delivery, so Watchdog_enter() and
+ * Watchdog_leave() don't wait for a slow mail server.
+ */
+static void *_watchdog(void *args) {
+        set_signal_block();
+        DEBUG("Watchdog started\n");
+        LOCK(mutex)
+        {
+                while (running) {
+                        if (current.service && ! current.stalled) {
+                                long long duration = Time_monotonic() - current.started;
+                                if (duration >= Run.watchdog.timeout * 1000LL) {
+                                        current.stalled = duration;
+                                        Run.timing.stalls++;
+                                        // The service can't be freed meanwhile: a reload runs in the blocked validation thread and stops the watchdog first
+                                        Service_T s = current.service;
+                                        Mutex_unlock(mutex);
+                                        Event_notify(Run.system, Event_Instance, State_Failed, Run.system->action_MONIT_STALL, "Monit stalled -- check of '%s' is running for %s", s->name, Str_milliToTime(duration, (char[23]){}));
+                                        Mutex_lock(mutex);
+                                        if (! running)
+                                                break;
+                                }
+                        }
+                        struct timespec wait = {.tv_sec = Time_now() + 1, .tv_nsec = 0};
+                        Sem_timeWait(cond, mutex, wait);
+                }
+        }
+        END_LOCK;
+#ifdef HAVE_OPENSSL
+        Ssl_threadCleanup();
+#endif
+        DEBUG("Watchdog stopped\n");
+        return NULL;
+}
+
+
+/* ------------------------------------------------------------------ Public */
+
+
+void Watchdog_start() {
+        if (Run.watchdog.timeout > 0 && ! running) {
+                Mutex_init(mutex);
+                Sem_init(cond);
+                memset(&current, 0, sizeof(current));
+                running = true;
+                Thread_create(thread, _watchdog, NULL);
+        }
+}
+
+
+void Watchdog_stop() {
+        if (running) {
+                LOCK(mutex)
+                {
+                        running = false;
+                        Sem_signal(cond);
+                }
+                END_LOCK;
+                Thread_join(thread);
+                Sem_destroy(cond);
+                Mutex_destroy(mutex);
+        }
+}
+
+
+void Watchdog_enter(Service_T s) {
+        ASSERT(s);
+        if (running) {
+                LOCK(mutex)
+                {
+                        current.service = s;
+                        current.started = Time_monotonic();
+                        current.stalled = 0;
+                }
+                END_LOCK;
+        }
+}
+
+
+void Watchdog_leave(Service_T s) {
+        ASSERT(s);
+        if (running) {
+                long long stalled, duration;
+                LOCK(mutex)
+                {
+                        stalled = current.stalled;
+                        duration = Time_monotonic() - current.started;
+                        current.service = NULL;
+                        current.stalled = 0;
+                }
+                END_LOCK;
+                // The stall was notified by the watchdog thread, send the recovery outside of the lock
+                if (stalled) {
+                        s->stall.count++;
+                        Event_notify(Run.system, Event_Instance, State_Succeeded, Run.system->action_MONIT_STALL, "Monit resumed -- check of '%s' finished after %s", s->name, Str_milliToTime(duration, (char[23]){}));
+                        if (Run.watchdog.isolate) {
+                                long long isolate = Run.watchdog.timeout * 1000LL << (s->stall.count - 1 < ISOLATE_MAX_SHIFT ? s->stall.count - 1 : ISOLATE_MAX_SHIFT);
+                                s->stall.until = Time_monotonic() + isolate;
+                                LogWarning("'%s' isolated for %s after a stalled check\n", s->name, Str_milliToTime(isolate, (char[23]){}));
+                        }
+                } else {
+                        s->stall.count = 0;
+                }
+        }
+}
+
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) Tildeslash Ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ *
+ * You must obey the GNU Affero General Public License in all respects
+ * for all of the code used other than OpenSSL.
+ */
+
+
+#ifndef MONIT_WATCHDOG_H
+#define MONIT_WATCHDOG_H
+
+
+/**
+ * Watchdog of the service checks.
+ *
+ * The service checks run sequentially in the validation thread, so if one
+ * check blocks (for example a stat(2) on a hung NFS mount or a read from a
+ * stuck connection), no other service is monitored until it returns. The
+ * validation thread registers the currently executing check using
+ * Watchdog_enter() and Watchdog_leave(). A watchdog thread compares the
+ * check start time against the "set watchdog" timeout and, when exceeded,
+ * sends the Monit instance stall alert from the watchdog thread, so the
+ * stall is reported while the check is still hung. The recovery alert is
+ * sent when the check returns. The watchdog doesn't interrupt the hung
+ * check, the monitoring of other services waits until it returns. If the
+ * isolate option is set, the service is then skipped in the next cycles
+ * with an exponential backoff, so a check which hangs repeatedly doesn't
+ * stop the monitoring in each cycle.
+ *
+ *  @file
+ */
+
+
+/**
+ * Start the watchdog thread if the watchdog is enabled
+ */
+void Watchdog_start();
+
+
+/**
+ * Stop the watchdog thread
+ */
+void Watchdog_stop();
+
+
+/**
+ * Register the start of the service check
+ * @param s The service which is going to be checked
+ */
+void Watchdog_enter(Service_T s);
+
+
+/**
+ * Register the end of the service check started by Watchdog_enter()
+ * @param s The service which was checked
+ */
+void Watchdog_leave(Service_T s);
+
+
+#endif
+
@@ -0,0 +1,75 @@
+#!/bin/bash
+#
+# Scheduler tests: run monit in the foreground with a generated control
+# file and check that program services with an own schedule are started.
+#
+# Usage: scheduler.sh [path to monit]
+
+MONIT=${1:-../monit}
+DIR=$(mktemp -d -t monit-test.XXXXXX) || exit 1
+PID=
+trap 'test -n "$PID" && kill $PID 2>/dev/null; rm -rf "$DIR"' EXIT
+
+fail() {
+        echo "FAILED: $*"
+        test -f "$DIR/monit.log" && cat "$DIR/monit.log"
+        exit 1
+}
+
+# Run monit with the control file for the given number of seconds
+run() {
+        rm -f "$DIR"/*.runs "$DIR/monit.log"
+        chmod 600 "$DIR/monitrc"
+        "$MONIT" -t -c "$DIR/monitrc" >/dev/null || fail "control file syntax"
+        "$MONIT" -I -c "$DIR/monitrc" >/dev/null 2>&1 &
+        PID=$!
+        sleep $1
+        kill $PID
+        wait $PID 2>/dev/null
+        PID=
+}
+
+# Write the global part of the control file, the arguments are appended to "set daemon"
+daemon() {
+        cat > "$DIR/monitrc" <<-END
+	set daemon $*
+	set log $DIR/monit.log
+	set pidfile $DIR/monit.pid
+	set idfile $DIR/monit.id
+	set statefile $DIR/monit.state
+	END
+}
+
+# Append a program service which counts its runs in <name>.runs
+program() {
+        local name=$1
+        shift
+        cat >> "$DIR/monitrc" <<-END
+	check program $name with path "/bin/sh -c 'echo run >> $DIR/$name.runs'" $*
+	      if status != 0 then alert
+	END
+}
+
+# Check that the program service was started at least <count> times
+started() {
+        local runs=$(cat "$DIR/$1.runs" 2>/dev/null | wc -l)
+        test $runs -ge $2 || fail "program '$1' started $runs times, expected at least $2"
+        echo "=> program '$1' started $runs times: OK"
+}
+
+
+echo "=> Test1: program service with a millisecond interval"
+daemon 60
+program interval every 300 milliseconds
+run 4
+started interval 5
+
+echo "=> Test2: program services spread over the poll interval"
+daemon 1 spread
+program cycle
+program skipcycles every 2 cycles
+run 6
+started cycle 3
+started skipcycles 2
+
+exit 0